@@ -31,14 +31,19 @@ printf "\nRunning the $case example!\n\n"
 # Clean the directory first
 rm -rf $case/LIFE $case/Results
 
-# Copy the params.h file into source folder
-cp $case/params.h ../inc/params.h
-
-# Build LIFE
-(cd .. && make clean && make)
-
-# Copy LIFE to case folder
-cp ../LIFE $case/.
+# Build LIFE (the case itself is read from $case/input/case.config)
+if [ -f $case/build.options ]; then
+
+	# Build with the example build options in a scratch copy of the source (removed on exit)
+	source ../testing/build-life.sh
+	buildDir=$(mktemp -d)
+	trap 'rm -rf "$buildDir"' EXIT
+	buildLife ../inc/params.h $buildDir $(grep -v "^#" $case/build.options | xargs)
+	cp $buildDir/LIFE $case/.
+else
+	(cd .. && make)
+	cp ../LIFE $case/.
+fi
 
 # Run LIFE
 (cd $case && ./LIFE)
@@ -20,11 +20,118 @@
 #define GRID_H
 
 // Includes
-#include "defs.h"
+#include "params.h"
+#include "Utils.h"
+
+// Check the build options can be used together (so an invalid build fails in make rather than on startup)
+#if defined HALO && defined AA_PATTERN
+#error "Ghost layer (HALO) is not supported with AA pattern streaming (AA_PATTERN)"
+#endif
+#if defined FUSED && (defined AA_PATTERN || defined HALO || defined VECTORISED)
+#error "Fused kernel (FUSED) is not supported with AA_PATTERN, HALO or VECTORISED"
+#endif
+#if defined MOMENTS && (defined AA_PATTERN || defined HALO || defined VECTORISED || defined FUSED || defined TILED)
+#error "Moment storage (MOMENTS) is not supported with AA_PATTERN, HALO, VECTORISED, FUSED or TILED"
+#endif
+#if defined MPI_SLABS && (defined AA_PATTERN || defined HALO || defined FUSED || defined MOMENTS)
+#error "MPI slabs (MPI_SLABS) are not supported with AA_PATTERN, HALO, FUSED or MOMENTS"
+#endif
+#if defined SPARSE && (defined AA_PATTERN || defined HALO || defined VECTORISED || defined FUSED || defined MOMENTS || defined TILED || defined MPI_SLABS)
+#error "Sparse lattice (SPARSE) is not supported with AA_PATTERN, HALO, VECTORISED, FUSED, MOMENTS, TILED or MPI_SLABS"
+#endif
+#if defined TEMPORAL_STEPS && (defined AA_PATTERN || defined HALO || defined FUSED || defined MOMENTS || defined SPARSE || defined LEAN_MEMORY || defined MPI_SLABS)
+#error "Temporal blocking (TEMPORAL_STEPS) is not supported with AA_PATTERN, HALO, FUSED, MOMENTS, SPARSE, LEAN_MEMORY or MPI_SLABS"
+#endif
+#ifdef SPARSE
+static_assert(LAYOUT == eAoS, "Sparse lattice (SPARSE) is only supported with the eAoS LAYOUT");
+#endif
 
 // Forward declarations
 class ObjectsClass;
 
+// Size of population storage (padded with a ghost layer for periodic streaming, set when the grid is built)
+extern int NxPad;
+extern int NyPad;
+
+// Storage type of the populations (collision is always done in double)
+typedef conditional<POP_PRECISION == eDouble, double, float>::type popType;
+
+// Reference density (eFloatDelta stores the deviation from w * rhoRef)
+const double rhoRef = 1.0;
+
+// Gravity and pressure gradient force every site (otherwise only IBM support sites are forced, set when the grid is built)
+extern bool xyForce;
+
+// Allocator which aligns lattice arrays (see Utils::latticeAlloc) and leaves new elements unwritten (so pages are first touched by the threads that use them)
+template <typename T>
+struct FirstTouchAllocator : allocator<T> {
+
+	// Rebind to other element types
+	template <typename U>
+	struct rebind {typedef FirstTouchAllocator<U> other;};
+
+	// Constructors
+	FirstTouchAllocator() {}
+	template <typename U>
+	FirstTouchAllocator(const FirstTouchAllocator<U>&) {}
+
+	// Allocate and free through the lattice allocator
+	T *allocate(size_t n, const void* = 0) {return static_cast<T*>(Utils::latticeAlloc(n * sizeof(T)));}
+	void deallocate(T *ptr, size_t n) {Utils::latticeFree(ptr, n * sizeof(T));}
+
+	// Default-initialise (does not touch the memory) or construct from a value
+	template <typename U>
+	void construct(U *ptr) {::new(static_cast<void*>(ptr)) U;}
+	template <typename U, typename... Args>
+	void construct(U *ptr, Args&&... args) {::new(static_cast<void*>(ptr)) U(std::forward<Args>(args)...);}
+};
+
+// Vector type of the lattice arrays
+template <typename T>
+using latVector = vector<T, FirstTouchAllocator<T>>;
+
+// Boundary site descriptor (built once when initialising the grid)
+struct BCDescriptor {
+	int i;									// Site x index
+	int j;									// Site y index
+	array<int, 3> inward;					// Sites one, two and three steps along the normal
+	array<int, dims> normal;				// Normal vector (pointing into the fluid)
+	eDirectionType normalDirection;			// Normal direction
+	bool corner;							// Corner site (normal has two components)
+	int unknownMask;						// Links which are unknown after streaming (bit v)
+	int buriedMask;							// Unknown links along the wall of a corner (bit v)
+};
+
+// Refined patch (twice as fine in space and time as its parent level, nested around the bodies)
+struct GridPatch {
+	int level;								// Refinement level (the grid itself is level 0)
+	int i0;									// Parent x index of the first patch site
+	int j0;									// Parent y index of the first patch site
+	int nx;									// Number of patch sites in x-direction
+	int ny;									// Number of patch sites in y-direction
+	array<double, dims> origin;				// Position of the first patch site (m)
+	double Dx;								// Length scaling
+	double Dt;								// Time scaling
+	double Dm;								// Mass scaling
+	double omega;							// Relaxation frequency
+	array<double, dims> forceXY;			// Cartesian force (pressure and gravity, same at every site)
+	vector<double> f;						// Populations (post-stream)
+	vector<double> f_n;						// Populations (start of sub-step)
+	vector<double> u;						// Velocity
+	vector<double> u_n;						// Velocity (start of sub-step)
+	vector<double> rho;						// Density
+	vector<double> rho_n;					// Density (start of sub-step)
+	vector<double> force_ibm;				// Cartesian force (IBM)
+	vector<char> forceMask;					// Site has an IBM force (1) or not (0)
+	vector<int> forceSites;					// Sites with an IBM force (reset before each spread)
+	vector<int> ringSites;					// Parent sites along the patch edges (and one past each end)
+	vector<double> fRing;					// Parent populations on the ring (end of the parent step)
+	vector<double> fRing_n;					// Parent populations on the ring (start of the parent step)
+	vector<int> edgeSites;					// Patch sites on the edges (rebuilt from the parent every sub-step)
+	vector<array<int, 4>> edgeFrom;			// Ring sites each edge site is interpolated from
+	vector<array<double, 4>> edgeWeight;	// Weight of each ring site
+};
+
 // Grid class
 class GridClass {
 
@@ -59,34 +166,75 @@ public:
 	// Big or little endian
 	bool bigEndian;							// For binary output
 
+	// Slab of lattice columns owned by this rank (whole lattice with one rank)
+	int rank;								// Rank of this process
+	int nRanks;								// Number of ranks
+	int iStart;								// First column owned by this rank
+	int iEnd;								// One past the last column owned by this rank
+	int nSites;								// Number of sites in the lattice arrays (non-solid sites plus one shared solid site with the sparse lattice, slab plus ghost columns with MPI)
+	int idStart;							// First site ID owned by this rank
+	int idEnd;								// One past the last site ID owned by this rank
+
 	// Private members
 private:
 
-	// Lattice parameters
-	double c_s;								// Speed of sound
-	array<double, nVels> w;					// Weightings
-	array<int, nVels * dims> c;				// Direction vectors
-	array<int, nVels> opposite;				// Opposite vectors
+	// Lattice parameters (compile-time from the lattice descriptor)
+	static constexpr double c_s = Lattice::c_s;					// Speed of sound
+	static constexpr const double *w = Lattice::w;				// Weightings
+	static constexpr const int *c = Lattice::c;					// Direction vectors
+	static constexpr const int *opposite = Lattice::opposite;	// Opposite vectors
+	array<int, nVels> shift;									// Streaming offset between storage sites
 
 	// Grid values
 	double tau;								// Relaxation time
 	double nu;								// Lattice viscosity
 
 	// Flattened kernel arrays
-	vector<double> u;						// Velocity
-	vector<double> u_n;						// Velocity (start of timestep)
-	vector<double> rho;						// Density
-	vector<double> rho_n;					// Density (start of timestep)
-	vector<double> force_xy;				// Cartesian force (pressure and gravity)
-	vector<double> force_ibm;				// Cartesian force (IBM)
-	vector<eLatType> type;					// Lattice type matrix
-	vector<double> f;						// Populations
-	vector<double> f_n;						// Populations (start of timestep)
+	latVector<double> u;					// Velocity
+	latVector<double> u_n;					// Velocity (start of timestep, not used with lean memory)
+	latVector<double> rho;					// Density
+	latVector<double> rho_n;				// Density (start of timestep, not used with lean memory)
+	latVector<double> force_xy;				// Cartesian force (pressure and gravity, not used with lean memory)
+	array<double, dims> bodyForce;			// Cartesian force (pressure and gravity, same at every site with lean memory)
+	latVector<double> force_ibm;			// Cartesian force (IBM)
+	latVector<char> forceMask;				// Site has an IBM force (1) or not (0)
+	vector<int> forceSites;					// Sites with an IBM force (reset before each spread)
+	latVector<eLatType> type;				// Lattice type matrix
+	latVector<popType> f;					// Populations (BC sites only with moment storage)
+	latVector<popType> f_n;					// Populations (start of timestep, not used with AA pattern or moment storage)
+	vector<double> f_out;					// Outlet populations (start of timestep, AA pattern, fused kernel and moment storage)
+	bool aaSwapped;							// AA pattern: populations are held swapped at their source site
+	int sidStart;							// First storage site of this rank (slab, ghost and padding sites)
+	int sidEnd;								// One past the last storage site of this rank
 
 	// Boundary conditions
-	vector<int> BCVec;						// Vector of site IDs to apply boundary conditions
+	vector<int> BCVec;						// Vector of site IDs to apply boundary conditions (grouped by type and normal)
+	vector<BCDescriptor> BCDesc;			// Descriptor of each site in BCVec
+	vector<int> BCGroup;					// Start of each group in BCVec (plus the end)
+	vector<int> BCPos;						// Position of site in BCVec (-1 if not a BC site)
+	vector<double> uBC;						// Velocity set by the BC at each site in BCVec (lean memory)
+	vector<double> rhoBC;					// Density set by the BC at each site in BCVec (lean memory)
+	vector<array<int, 2>> haloVec;			// Ghost layer copies (from and to index in f)
 	vector<double> delU;					// Convective speed through boundary
 
+	// Fused kernel
+	vector<int> deferVec;					// Vector of site IDs collided after BCs and IBM (BC sites first)
+	vector<int> deferPos;					// Position of site in deferVec (-1 if not deferred)
+	vector<double> fDefer;					// Post-stream populations of deferred sites
+
+	// Moment storage
+	latVector<double> mom;					// Post-stream moments (rho, jx, jy, Pxx, Pyy, Pxy)
+	latVector<double> mom_n;				// Post-stream moments (start of timestep)
+	vector<double> fColumns;				// Three rebuilt columns of post-collision populations for each thread
+
+	// Sparse lattice
+	vector<array<int, 3>> sparseRun;		// Runs of non-solid sites up each column (first j, one past the last j and site ID of the first)
+	vector<int> sparseCol;					// Start of each column in sparseRun (plus the end)
+	vector<int> sparseColumns;				// Site IDs of three consecutive columns for each thread
+
+	// Refinement
+	vector<GridPatch> patch;				// Refined patches (patch[l - 1] is level l)
+
 	// Helper arrays
 	vector<double> u_in;					// Inlet velocity profile
 	vector<double> rho_in;					// Inlet density profile
@@ -95,6 +243,14 @@ private:
 	double startTime;							// Start time when clock is called
 	double loopTime;							// Average loop time
 
+	// Kernels specialised for each collision operator
+	struct KernelSet {
+		void (GridClass::*step)();				// Advance one time step
+		void (GridClass::*initial)();			// Collide all sites to start the fused kernel
+	};
+	static const KernelSet kernelTable[];		// Kernels for each collision operator (indexed by eCollisionType)
+	KernelSet kernels;							// Kernels for the collision operator of this case
+
 	// Public methods
 public:
 
@@ -109,28 +265,332 @@ public:
 	void readRestart();						// Read restart file
 	void startClock();						// Start the clock for getting MLUPS
 
+	// Refinement
+	void refineAround(const array<double, dims> &lo, const array<double, dims> &hi, int nLevels, double margin);	// Build nested patches around a box
+	int bodyLevel(const array<double, dims> &lo, const array<double, dims> &hi) const;								// Finest level which holds a body
+	double levelDx(int level) const;																				// Lattice spacing of a level
+
 	// Private methods
 private:
 
-	// LBM methods
+	// LBM methods (templated on the collision operator are picked through kernelTable)
+	template <eCollisionType CollisionType>
+	void solverStep();															// Advance one time step (or several when blocking in time)
+	template <eCollisionType CollisionType>
 	void lbmKernel();															// Main LBM kernel
-	void streamCollide(int i, int j, int id);									// Stream and collide in one go (push algorithm)
+	template <eCollisionType CollisionType>
+	void temporalKernel();														// Advance several time steps per sweep (temporal blocking)
+	template <eCollisionType CollisionType>
+	void temporalStream(int i, int tStep);										// Stream and collide a column of a step (temporal blocking)
+	void temporalMacroscopic(int i);											// Update fluid site macroscopic values of a column (temporal blocking)
+	template <eCollisionType CollisionType>
+	void temporalBoundary(int i, int tStep, bool keep);							// Apply BCs of a column and keep it for the next step (temporal blocking)
+	bool temporalBlocking();													// Check if several time steps can be advanced per sweep
+	template <eCollisionType CollisionType>
+	void sweepSites(int i, int jStart, int jEnd);								// Stream and collide a run of sites in a column
+	template <eCollisionType CollisionType>
+	void streamCollide(int i, int j, int id);									// Stream and collide in one go (push algorithm or AA pattern)
+	template <eCollisionType CollisionType>
+	void streamCollideClipped(int i, int j, int id);							// Stream and collide without wrapping in x (temporal blocking)
+	template <eCollisionType CollisionType>
+	void streamCollideLanes(int i, int j, int id);								// Stream and collide a group of consecutive sites (SIMD)
+	template <eCollisionType CollisionType>
+	void streamCollideSparse(int j, int id, const int *const idNbr[3]);			// Stream and collide at a non-solid site (sparse lattice)
+	void sparseColumn(int i, int *idCol) const;									// Get site IDs up a column from its runs of non-solid sites
+	void readPops(int id, array<double, nVels> &fPop);							// Read in populations to be collided at a site
+	void writePops(int i, int j, array<double, nVels> &fPop);					// Stream post-collision populations from a site
+	template <eCollisionType CollisionType>
+	void collide(int id, array<double, nVels> &fPop);							// Collide populations at a site (overwritten with post-collision)
+	template <eCollisionType CollisionType>
+	void fusedKernel(int i, int j, int id);										// Pull, compute macroscopic and collide in one go
+	template <eCollisionType CollisionType>
+	void collideInPlace(int id);												// Collide post-stream populations in place (fused kernel)
+	void buildDeferred();														// Build list of sites collided after BCs and IBM
+	template <eCollisionType CollisionType>
+	void collideDeferred();														// Collide sites that had to wait for BCs and IBM
+	template <eCollisionType CollisionType>
+	void collideInitial();														// Collide all sites to start the fused kernel
+	void getPostStream(int i, int j, int id, array<double, nVels> &fPop);		// Get post-stream populations at a site
+	void putPostStream(int id, const array<double, nVels> &fPop);				// Set post-stream populations at a site
+	void pullMoments(int j, int id, const double *const fNbr[3]);				// Pull rebuilt populations and store their moments
+	void projectColumn(int i, double *fCol);									// Collide and rebuild the populations of a column
+	void collideMoments(int id, double *m);									// Collide start of timestep moments of a site
+	double projectMoments(const double *m, int v) const;						// Get population v from the stored moments
+	void setMoments(int id, const array<double, nVels> &fPop);					// Store moments of the populations at a site
+	template <eCollisionType CollisionType>
+	void collideSite(double rho, double ux, double uy,
+			double Fx, double Fy, double *fPop, int stride, double omegaSite = omega) const;		// Collide populations given the site values (at the grid or a patch rate)
+	void collideCentral(double rho, double ux, double uy,
+			double Fx, double Fy, double *fPop, int stride, double omegaSite) const;		// Collide populations with the central moments operator (given relaxation frequency)
+	template <eCollisionType CollisionType>
+	void collideSiteUnforced(double rho, double ux, double uy,
+			double *fPop, int stride, double omegaSite = omega) const;					// Collide populations given the site values (no force)
+	double localOmega(double rho, double ux, double uy,
+			const double *fPop, int stride, double omegaSite) const;				// Get local relaxation frequency (eddy viscosity if LES is on)
+	double eddyOmega(double rho, double ux, double uy,
+			double pxx, double pyy, double pxy, double omegaSite) const;			// Get relaxation frequency from the second moments (Smagorinsky)
+	bool isForced(int id) const;												// Check if a site has any force
+	template <eCollisionType CollisionType>
 	double equilibrium(int id, int v);											// Equilibrium function
-	double latticeForce(int id, int v);											// Discretise lattice force (BGK only)
+	template <eCollisionType CollisionType>
+	double equilibrium(double rho, double ux, double uy, int v) const;			// Equilibrium function (given site values)
+	double latticeForce(double ux, double uy, double Fx, double Fy, int v) const;	// Discretise lattice force (BGK only)
 	void macroscopic(int id);													// Compute macroscopic quantities
-	void applyBCs(int i, int j, int id);										// Apply boundary conditions
+	void macroscopic(int id, const array<double, nVels> &fPop);				// Compute macroscopic quantities from given populations
+	void womersleyForce(int id, double rhoSite, int tStep);						// Set forcing for Womersley pressure gradient
+	void womersleyForce(int tStep);												// Set uniform forcing for Womersley pressure gradient (lean memory)
+	template <eCollisionType CollisionType>
+	void boundaryKernel();														// Apply BCs and update macroscopic on all BC sites
+	template <eCollisionType CollisionType, eLatType BCType>
+	void boundaryGroup(int start, int end, double rampCoefficient);				// Apply BCs and update macroscopic on a group of BC sites
+	template <eCollisionType CollisionType>
+	void applyBCs(int bc, double rampCoefficient);								// Apply boundary condition at a BC site
+	template <eCollisionType CollisionType, eLatType BCType>
+	void applyBC(int bc, double rampCoefficient);								// Apply boundary condition of given type at a BC site
 	void convectiveSpeed();														// Get convective speed through right boundary
 	void convectiveBC(int j, int id);											// Convective BC
-	void regularisedBC(int i, int j, int id,
-			array<int, dims> &normalVector, eDirectionType normalDirection);	// Regularised BC
-
+	template <eCollisionType CollisionType, eLatType BCType>
+	void regularisedBC(int bc);													// Regularised BC
+	void exchangePops();														// Send populations streamed into the ghost columns to the neighbouring ranks
+	void exchangeMacroscopic();													// Send density and velocity of the edge columns to the neighbouring ranks
+	template <eCollisionType CollisionType>
+	void patchKernel(int level, bool last);										// Advance a refined patch over one step of its parent
+	template <eCollisionType CollisionType>
+	void patchStreamCollide(GridPatch &p, int fi, int fj);						// Stream and collide at a patch site
+	template <eCollisionType CollisionType>
+	void patchEdge(GridPatch &p, int e, double frac);							// Rebuild a patch edge site from the parent
+	template <eCollisionType CollisionType>
+	void restrictSite(GridPatch &p, int pi, int pj, bool withIBM);				// Set a parent site inside the patch from the patch
+	template <eCollisionType CollisionType>
+	void rescalePops(const double *fIn, const array<double, dims> &FIn, const array<double, dims> &FOut,
+			double ratio, double *fOut) const;									// Move populations between levels (rescale non-equilibrium part)
+	void patchMacroscopic(GridPatch &p, int id, bool withIBM);					// Compute macroscopic quantities at a patch site
+	void getLevelPops(int level, int id, double *fPop);							// Read populations at a site of a level
+	void setLevelPops(int level, int id, const double *fPop);					// Store populations at a site of a level
 
 	// Initialisation
 	void initialiseGrid();									// Initialise grid values
+	void buildBCDescriptors();								// Group BC sites and build their descriptors
+	void initialisePatch(GridPatch &p);						// Interpolate patch values from its parent
+	void readSolidMask(vector<char> &solid);				// Read solid sites of the slab from input/solid.pgm
+	void buildSparse();										// Number the non-solid sites in runs up each column
+
+	// Refinement I/O
+	string vtkHeader(int nx, int ny, const array<double, dims> &origin, double spacing) const;	// Header of an image VTK file
+	void writePatchVTK(const GridPatch &p);														// Write patch VTK
+	void writePatchRestart();																	// Write refined patches restart file
+	bool readPatchRestart();																	// Read refined patches restart file (false if it does not match)
 
 	// Helper routines
 	array<int, dims> getNormalVector(int i, int j, eDirectionType &normalDirection);	// Get normal vector for boundary site
-	double getRampCoefficient();														// Get inlet ramp coefficient
+	double getRampCoefficient(int tStep);												// Get inlet ramp coefficient at a time step
+	inline bool ownsColumn(int i) const;												// Check if column i is in the slab of this rank
+	inline int siteIdx(int i, int j) const;												// Get site ID of lattice site (i, j)
+	inline array<int, dims> sitePos(int id) const;										// Get lattice position of a site ID
+	int levelSiteIdx(int level, int i, int j) const;									// Get site ID of site (i, j) of a level
+	int markerLevel(const array<double, dims> &pos) const;								// Finest level which holds the IBM support of a marker
+	bool inInterior(int level, const array<double, dims> &pos) const;					// Check if the IBM support around a position is inside a patch
+	array<double, dims> levelOrigin(int level) const;									// Position of the first site of a level
+	int levelNx(int level) const;														// Number of sites of a level in x-direction
+	int levelNy(int level) const;														// Number of sites of a level in y-direction
+	double levelOmega(int level) const;													// Relaxation frequency of a level
+	array<double, dims> levelForceXY(int level) const;									// Cartesian force (pressure and gravity) of a level
+	inline int layoutIdx(int sid, int v) const;											// Get storage index of population slot at storage site
+	inline int popIdx(int id, int v) const;												// Get storage index of population slot in f and f_n
+	inline int fIdx(int id, int v) const;												// Get index of current population in f and f_n
+	inline double getPop(const latVector<popType> &fVec, int idx, int v) const;			// Read population v stored at idx (in double)
+	inline void setPop(latVector<popType> &fVec, int idx, int v, double fVal) const;	// Store population v at idx
+	inline double &rhoStart(int id);													// Density at start of timestep
+	inline double &uStart(int id, int d);												// Velocity at start of timestep
+	inline double &rhoBCSite(int bc);													// Density set by the BC at a BC site
+	inline double &uBCSite(int bc, int d);												// Velocity set by the BC at a BC site
+	inline double siteForce(int id, int d) const;										// Cartesian force (pressure and gravity) at a site
+	double bytesPerSite(bool dense = false) const;										// Memory held by the lattice arrays per site (or if every site was stored)
 };
 
+// Check if column i is in the slab of this rank
+inline bool GridClass::ownsColumn(int i) const {
+
+	// Inside slab
+	return (i >= iStart && i < iEnd);
+}
+
+// Get site ID of lattice site (i, j) in the lattice arrays
+inline int GridClass::siteIdx(int i, int j) const {
+
+	// Find the run of the column holding the site (solid sites all share the site after the stored ones)
+#ifdef SPARSE
+	for (int r = sparseCol[i]; r < sparseCol[i + 1] && j >= sparseRun[r][0]; r++) {
+		if (j < sparseRun[r][1])
+			return sparseRun[r][2] + j - sparseRun[r][0];
+	}
+	return idEnd;
+
+	// Local column of the slab (periodic images of the neighbouring columns land on the ghost columns)
+#elif defined MPI_SLABS
+	int il = i - iStart + 1;
+	if (il < 0)
+		il += Nx;
+	else if (il > iEnd - iStart + 1)
+		il -= Nx;
+	return il * Ny + j;
+#else
+	return i * Ny + j;
+#endif
+}
+
+// Get lattice position of a site ID
+inline array<int, dims> GridClass::sitePos(int id) const {
+
+	// Find the run holding the site and then its column (sparse lattice)
+#ifdef SPARSE
+	int r = static_cast<int>(upper_bound(sparseRun.begin(), sparseRun.end(), id, [](int k, const array<int, 3> &run) {return k < run[2];}) - sparseRun.begin()) - 1;
+	int i = static_cast<int>(upper_bound(sparseCol.begin(), sparseCol.end(), r) - sparseCol.begin()) - 1;
+	return {i, sparseRun[r][0] + id - sparseRun[r][2]};
+
+	// Local column of the slab
+#elif defined MPI_SLABS
+	return {(id / Ny + iStart - 1 + Nx) % Nx, id % Ny};
+#else
+	return {id / Ny, id % Ny};
+#endif
+}
+
+// Get storage index of population slot v at storage site sid (depends on storage layout)
+inline int GridClass::layoutIdx(int sid, int v) const {
+
+	// Structure of arrays
+	if (LAYOUT == eSoA)
+		return v * NxPad * NyPad + sid;
+
+	// Array of structures of arrays (blocks of consecutive sites)
+	else if (LAYOUT == eAoSoA)
+		return (sid / blockWidth) * blockWidth * nVels + v * blockWidth + sid % blockWidth;
+
+	// Array of structures
+	else
+		return sid * nVels + v;
+}
+
+// Get storage index of population slot v at site id
+inline int GridClass::popIdx(int id, int v) const {
+
+	// Only BC sites keep populations (moment storage)
+#ifdef MOMENTS
+	return BCPos[id] * nVels + v;
+
+	// Only non-solid sites keep populations (sparse lattice)
+#elif defined SPARSE
+	return id * nVels + v;
+
+	// Shift into the padded lattice
+#elif defined HALO
+	return layoutIdx(id + NyPad + 1 + 2 * (id / Ny), v);
+#else
+	return layoutIdx(id, v);
+#endif
+}
+
+// Get index of current (post-stream) population v at site id
+inline int GridClass::fIdx(int id, int v) const {
+
+	// After an even AA step the population is held in the opposite slot of its source site
+#ifdef AA_PATTERN
+	if (aaSwapped) {
+
+		// Get source site (wrapping periodically)
+		int jSrc = id % Ny - c[v * dims + eY];
+		int src = id - c[v * dims + eX] * Ny - c[v * dims + eY];
+		if (jSrc < 0)
+			src += Ny;
+		else if (jSrc >= Ny)
+			src -= Ny;
+		if (src < 0)
+			src += Nx * Ny;
+		else if (src >= Nx * Ny)
+			src -= Nx * Ny;
+		return popIdx(src, opposite[v]);
+	}
+#endif
+
+	// Otherwise it is stored in place
+	return popIdx(id, v);
+}
+
+// Read population v stored at idx (in double)
+inline double GridClass::getPop(const latVector<popType> &fVec, int idx, int v) const {
+
+	// Add back the reference equilibrium if storing the deviation
+	if (POP_PRECISION == eFloatDelta)
+		return static_cast<double>(fVec[idx]) + w[v] * rhoRef;
+	else
+		return static_cast<double>(fVec[idx]);
+}
+
+// Store population v at idx
+inline void GridClass::setPop(latVector<popType> &fVec, int idx, int v, double fVal) const {
+
+	// Take off the reference equilibrium if storing the deviation
+	if (POP_PRECISION == eFloatDelta)
+		fVec[idx] = static_cast<popType>(fVal - w[v] * rhoRef);
+	else
+		fVec[idx] = static_cast<popType>(fVal);
+}
+
+// Density at start of timestep (not yet overwritten when it is needed with lean memory)
+inline double &GridClass::rhoStart(int id) {
+
+	// Get value
+#ifdef LEAN_MEMORY
+	return rho[id];
+#else
+	return rho_n[id];
+#endif
+}
+
+// Velocity at start of timestep (not yet overwritten when it is needed with lean memory)
+inline double &GridClass::uStart(int id, int d) {
+
+	// Get value
+#ifdef LEAN_MEMORY
+	return u[id * dims + d];
+#else
+	return u_n[id * dims + d];
+#endif
+}
+
+// Density set by the BC at a BC site (start of timestep array is free once the site has collided)
+inline double &GridClass::rhoBCSite(int bc) {
+
+	// Get value
+#ifdef LEAN_MEMORY
+	return rhoBC[bc];
+#else
+	return rho_n[BCVec[bc]];
+#endif
+}
+
+// Velocity set by the BC at a BC site (start of timestep array is free once the site has collided)
+inline double &GridClass::uBCSite(int bc, int d) {
+
+	// Get value
+#ifdef LEAN_MEMORY
+	return uBC[bc * dims + d];
+#else
+	return u_n[BCVec[bc] * dims + d];
+#endif
+}
+
+// Cartesian force (pressure and gravity) at a site
+inline double GridClass::siteForce(int id, int d) const {
+
+	// Get value
+#ifdef LEAN_MEMORY
+	(void)id;
+	return bodyForce[d];
+#else
+	return force_xy[id * dims + d];
+#endif
+}
+
 #endif // GRID_H
@@ -38,7 +38,7 @@ class IBMBodyClass {
 
 	// Default constructor and destructor
 public:
-	IBMBodyClass() {oPtr = NULL; ID = 0; flex = eRigid; bodyType = eCircle; sBody = NULL;};
+	IBMBodyClass() {oPtr = NULL; ID = 0; rank = 0; level = 0; flex = eRigid; bodyType = eCircle; sBody = NULL; refresh = true;};
 	~IBMBodyClass() {};
 
 	// Custom constructor for creating one object from vector of all objects
@@ -59,6 +59,8 @@ private:
 
 	// Body parameters
 	int ID;								// Body ID
+	int rank;							// Rank which does the FEM and epsilon of this body
+	int level;							// Refinement level the body starts on (0 for the grid)
 	eFlexibleType flex;					// Flexible or rigid
 	eBodyType bodyType;					// Type of body
 
@@ -67,6 +69,17 @@ private:
 
 	// Pointer to FEM body
 	FEMBodyClass *sBody;				// Pointer to structural solver
+
+	// Epsilon system (kept between solves so the storage is reused)
+	bool refresh;						// Flag to say support and epsilon need recomputing
+	vector<array<int, 4>> epsBins;		// Nodes binned by level and nearest lattice site
+	vector<int> epsNbrs;				// Neighbouring nodes of current row
+	vector<int> epsRowStart;			// Start of each row (CSR)
+	vector<int> epsCol;					// Column of each entry (CSR)
+	vector<double> epsVal;				// Value of each entry (CSR)
+	vector<double> epsRHS;				// Right hand side
+	vector<double> epsilon;				// Solution
+	vector<double> epsWork;				// Solver workspace
 };
 
 #endif // IBMBODY_H
@@ -37,7 +37,7 @@ class IBMNodeClass {
 
 	// Default constructor and destructor
 public:
-	IBMNodeClass() {iPtr = NULL; ID = 0; ds = 0.0; epsilon = 0.0; interpRho = 0.0; suppCount = 0;};
+	IBMNodeClass() {iPtr = NULL; ID = 0; rank = 0; level = 0; ds = 0.0; epsilon = 0.0; interpRho = 0.0; suppCount = 0; suppChanged = true;};
 	~IBMNodeClass() {};
 
 	// Custom constructor for building node
@@ -51,11 +51,14 @@ private:
 
 	// ID
 	int ID;									// Global node ID
+	int rank;								// Rank which owns the nearest lattice column (interpolates at this node)
+	int level;								// Refinement level the support sits on (0 for the grid)
 
 	// Positions, velocities and forces
 	array<double, dims> pos;				// Position of node
 	array<double, dims> vel;				// Velocity at node
 	array<double, dims> force;				// Force on IBM marker
+	array<double, dims> posEps;				// Position when support and epsilon were last computed
 
 	// Spacing and force multiplier
 	double ds; 								// Spacing between points (lattice units)
@@ -68,16 +71,17 @@ private:
 	// Vector of support points
 	size_t suppCount;						// Number of support points for this IBM marker
 	array<IBMSupportClass, suppSize> supp;	// Vector of support points
+	bool suppChanged;						// Support sites changed since force spreading list was built
 
 	// Private methods
 private:
 
 	// IBM methods
-	void findSupport();						// Find support
+	void findSupport();						// Find support (around posEps)
 	void computeDs();						// Compute spacing between IBM nodes
 	void interpolate();						// Interpolation
 	void forceCalc();						// Force calculation
-	void spread();							// Spread force back
+	double spreadForce(int s, int d) const;	// Force spread back to a support point
 	void updateMacroscopic();				// Update macroscopic values at support points
 };
 
@@ -36,7 +36,7 @@ class ObjectsClass {
 
 	// Default constructor and destructor
 public:
-	ObjectsClass() {gPtr = NULL; nFlex = 0; simDOFs = 0; hasIBM = false; hasFlex = false; subIt = 0; relax = relaxMax; subRes = 0.0; subNum = 0.0; subDen = 0.0;};
+	ObjectsClass() {gPtr = NULL; nFlex = 0; simDOFs = 0; hasIBM = false; hasFlex = false; subIt = 0; relax = relaxMax; subRes = 0.0; subNum = 0.0; subDen = 0.0; spreadRebuild = true; epsSolves = 0; epsFails = 0; epsSkips = 0; epsIts = 0; epsRes = 0.0;};
 	~ObjectsClass() {};
 
 	// Custom constructor for reading in geometries
@@ -63,6 +63,29 @@ private:
 	vector<IBMBodyClass> iBody;
 	vector<IBMNodeClass> iNode;
 
+	// Single body holding all markers for universal epsilon calculation
+	vector<IBMBodyClass> uniBody;
+
+	// Markers held by this rank (support touches its slab or it owns the body, every marker with one rank)
+	vector<int> flexNode;				// Node of each flexible marker held (the only ones that change during subiterations)
+	vector<int> rigidHeld;				// Node of each rigid marker held
+
+	// Rigid marker operator (support, ds and epsilon are fixed so interpolation and spreading are assembled once)
+	vector<int> rigidNode;				// Node of each interpolation row (rigid markers this rank interpolates)
+	vector<int> rigidStart;				// Start of each row's support sites (plus the end)
+	vector<int> rigidSite;				// Site ID of each support point
+	vector<double> rigidWeight;			// Dirac delta value of each support point
+	vector<array<int, 2>> rigidSpreadSite;	// Level and site ID of each spreading row (transpose)
+	vector<int> rigidSpreadStart;		// Start of each spreading row's contributions (plus the end)
+	vector<array<int, 2>> rigidSpreadSupp;	// Node and support point of each contribution
+	vector<double> rigidSpreadWeight;	// Epsilon * ds * dirac delta value of each contribution
+
+	// Force spreading (flexible support contributions grouped by site, in marker order within each site)
+	bool spreadRebuild;					// Flag to say the contributions have to be listed again
+	vector<vector<array<int, 4>>> spreadBuf;	// Contributions found by each thread
+	vector<array<int, 4>> spreadList;	// Level, site ID, node and support point of each contribution
+	vector<array<int, 5>> spreadSite;	// Level, site ID, rigid spreading row (-1 if none) and range of contributions in spreadList
+
 	// Subiteration loop parameters
 	int subIt;			// Number of iterations
 	double relax;		// Aitken relaxation parameter
@@ -70,6 +93,13 @@ private:
 	double subNum;		// Numerator
 	double subDen;		// Denominator
 
+	// Epsilon solve statistics (since last info write)
+	int epsSolves;		// Number of solves
+	int epsFails;		// Number of solves that stopped short of sparseTol (best iterate kept as it was within sparseFailTol)
+	int epsSkips;		// Number of solves skipped (markers hardly moved)
+	int epsIts;			// Total solver iterations
+	double epsRes;		// Largest final residual
+
 	// Public methods
 public:
 
@@ -85,6 +115,9 @@ public:
 	// Object routines
 	void objectKernel();					// Main kernel for objects
 
+	// MPI routines
+	void syncBodies();						// Get FEM state of each body and its markers from the rank that owns it (for output)
+
 	// Private methods
 private:
 
@@ -94,6 +127,20 @@ private:
 	void femKernel();						// Do FEM and update IBM positions and velocities
 	void recomputeObjectVals();				// Recompute objects support, ds, and epsilon
 	void computeEpsilon();					// Compute epsilon
+	void buildRigidOperator();				// Assemble operator of the rigid markers held by this rank
+	void updateRigidWeights();				// Refold epsilon into rigid spreading weights
+	void getSupportSites(vector<int> &suppVec);	// Get IDs of all IBM support sites
+	void findHeldMarkers();					// Find support and ds of the markers this rank holds and list them
+	array<int, 2> supportRanks(const array<double, dims> &pos) const;	// Get first and last rank whose slab holds support sites of a marker at pos
+	bool holdsMarker(const IBMNodeClass &node, const array<double, dims> &pos) const;	// Check if this rank holds a marker at pos
+	void markerRanks(const IBMNodeClass &node, vector<int> &ranks) const;	// Get ranks holding a marker
+
+	// MPI routines
+	void shareForces();						// Send marker forces from the ranks that interpolated them to the ranks holding the markers
+	void shareFlexMarkers();				// Send flexible markers from the ranks doing their FEM to the ranks holding them
+	void shareEpsilon();					// Send epsilon from the ranks that computed it to the ranks holding the markers
+	void shareRefresh();					// Share refresh flags of flexible bodies from the ranks doing their FEM
+	void shareResiduals();					// Share body residuals from the ranks doing their FEM
 
 	// Initialisation
 	void removeOverlapMarkers();			// Remove overlapping markers
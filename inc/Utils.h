@@ -21,6 +21,14 @@
 
 // Includes
 #include "params.h"
+#ifdef MPI_SLABS
+#include <mpi.h>
+#endif
+#ifdef NUMA_INTERLEAVE
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#endif
 
 // Forward declarations
 class GridClass;
@@ -57,22 +65,72 @@ void deleteVTKs(GridClass &grid);
 // Get number of omp threads (as built in doesn't work on GCC)
 int omp_thread_count();
 
+// Pin each omp thread to its own core
+void pinThreads();
+
+// Get list of cores the omp threads are running on
+string getThreadCores();
+
+// Allocate memory for a lattice array
+void *latticeAlloc(size_t bytes);
+
+// Free memory of a lattice array
+void latticeFree(void *ptr, size_t bytes);
+
+// Get the page size backing an address
+string getPageString(const void *ptr);
+
 // Convert seconds to hours:minutes:seconds
 array<int, 3> secs2hms(double seconds);
 
 // Get string for boundary condition
 string getBoundaryString(eLatType BCType);
 
+// Get string for population layout
+string getLayoutString(eLayoutType layout);
+
+// Get string for population storage precision
+string getPrecisionString(ePrecisionType precision);
+
+// Get string for collision operator
+string getCollisionString(eCollisionType collision);
+
 // Solve linear system using LAPACK routines
 vector<double> solveLAPACK(vector<double> A, vector<double> b, int BC = 0);
 
+// Solve sparse (CSR) linear system using Jacobi preconditioned BiCGSTAB (restarts once, returns false with the best iterate if not converged)
+bool solveBiCGSTAB(const vector<int> &rowStart, const vector<int> &col, const vector<double> &val, const vector<double> &b, vector<double> &x, vector<double> &work, int &its, double &res);
+
+// Get rank which owns item idx when n items are split into contiguous blocks over the ranks
+int blockRank(int idx, int n, int nRanks);
+
+// Share items between ranks (width values per item, each rank sends the items it owns)
+void shareOwned(vector<double> &vals, int width, const vector<int> &owner);
+
+// Send values to other ranks (one buffer for each rank) and get the values sent to this rank (one buffer from each rank)
+void exchange(const vector<vector<double>> &sendBuf, vector<vector<double>> &recvBuf);
+
+// Broadcast values from one rank to the others
+void broadcast(vector<double> &vals, int root);
+
+// Wait for all ranks
+void barrier();
+
 
 // DEFINITIONS
 // Error and exit
 inline void errorExit(const string &msg) {
 
-	// Write message then exit
+	// Write message (every rank can write errors)
+#ifdef MPI_SLABS
+	cout.clear();
+#endif
 	cout << endl << endl << msg << endl << endl;
+
+	// Exit (taking the other ranks down too)
+#ifdef MPI_SLABS
+	MPI_Abort(MPI_COMM_WORLD, 99);
+#endif
 	exit(99);
 }
 
@@ -133,46 +191,29 @@ inline T swapEnd(const T &val) {
 	return res;
 }
 
-// Extrapolate value
-inline double extrapolate(const vector<double> &vec, const array<int, dims> &normal, int order, int i, int j, int d = 0, int arrayDims = 1) {
+// Extrapolate value (from the sites one, two and three steps along the normal)
+template <typename VecType>
+inline double extrapolate(const VecType &vec, const array<int, 3> &inward, int order, int d = 0, int arrayDims = 1) {
 
 	// 0th order extrapolation
 	if (order == 0) {
 
-		// Get indices for extrapolation
-		int i1 = i + normal[eX];
-		int j1 = j + normal[eY];
-
 		// Return value
-		return vec[(i1 * Ny + j1) * arrayDims + d];
+		return vec[inward[0] * arrayDims + d];
 	}
 
 	// 1st order extrapolation
 	else if (order == 1) {
 
-		// Get indices for extrapolation
-		int i1 = i + normal[eX];
-		int i2 = i + 2 * normal[eX];
-		int j1 = j + normal[eY];
-		int j2 = j + 2 * normal[eY];
-
 		// Return value
-		return 2.0 * vec[(i1 * Ny + j1) * arrayDims + d] - vec[(i2 * Ny + j2) * arrayDims + d];
+		return 2.0 * vec[inward[0] * arrayDims + d] - vec[inward[1] * arrayDims + d];
 	}
 
 	// 2st order extrapolation
 	else if (order == 2) {
 
-		// Get indices for extrapolation
-		int i1 = i + normal[eX];
-		int i2 = i + 2 * normal[eX];
-		int i3 = i + 3 * normal[eX];
-		int j1 = j + normal[eY];
-		int j2 = j + 2 * normal[eY];
-		int j3 = j + 3 * normal[eY];
-
 		// Return value
-		return 2.5 * vec[(i1 * Ny + j1) * arrayDims + d] - 2.0 * vec[(i2 * Ny + j2) * arrayDims + d] + 0.5 * vec[(i3 * Ny + j3) * arrayDims + d];
+		return 2.5 * vec[inward[0] * arrayDims + d] - 2.0 * vec[inward[1] * arrayDims + d] + 0.5 * vec[inward[2] * arrayDims + d];
 	}
 
 	// Can't do other extrapolations
@@ -182,31 +223,22 @@ inline double extrapolate(const vector<double> &vec, const array<int, dims> &nor
 	}
 }
 
-// Get value by applying a zero gradient
-inline double zeroGradient(const vector<double> &vec, const array<int, dims> &normal, int order, int i, int j, int d = 0, int arrayDims = 1) {
+// Get value by applying a zero gradient (from the sites one and two steps along the normal)
+template <typename VecType>
+inline double zeroGradient(const VecType &vec, const array<int, 3> &inward, int order, int d = 0, int arrayDims = 1) {
 
 	// 1st order extrapolation
 	if (order == 1) {
 
-		// Get indices for extrapolation
-		int i1 = i + normal[eX];
-		int j1 = j + normal[eY];
-
 		// Return value
-		return vec[(i1 * Ny + j1) * arrayDims + d];
+		return vec[inward[0] * arrayDims + d];
 	}
 
 	// 2nd order extrapolation
 	else if (order == 2) {
 
-		// Get indices for extrapolation
-		int i1 = i + normal[eX];
-		int i2 = i + 2 * normal[eX];
-		int j1 = j + normal[eY];
-		int j2 = j + 2 * normal[eY];
-
 		// Return value
-		return (4.0 / 3.0) * vec[(i1 * Ny + j1) * arrayDims + d] - (1.0 / 3.0) * vec[(i2 * Ny + j2) * arrayDims + d];
+		return (4.0 / 3.0) * vec[inward[0] * arrayDims + d] - (1.0 / 3.0) * vec[inward[1] * arrayDims + d];
 	}
 
 	// Can't do other extrapolations
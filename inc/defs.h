@@ -23,7 +23,16 @@
 #include <iostream>
 #include <iomanip>
 #include <cmath>
+#include <type_traits>
+#include <algorithm>
+#include <tuple>
+#include <array>
+#include <map>
+#include <fstream>
+#include <sstream>
 #include <omp.h>
+#include <sched.h>
+#include <sys/mman.h>
 #include <boost/filesystem.hpp>
 using namespace std;
 
@@ -31,13 +40,50 @@ using namespace std;
 const string version = "v1.0.3";
 const string date = "10th June 2020";
 
-// Number of dimensions and lattice velocities
+// Number of dimensions
 const int dims = 2;
-const int nVels = 9;
+
+// D2Q9 lattice descriptor (compile-time so direction loops unroll with literal coefficients)
+struct D2Q9 {
+	static constexpr int nVels = 9;																// Number of lattice velocities
+	static constexpr double c_s = 0.5773502691896258;											// Speed of sound (1 / sqrt(3) in double)
+	static constexpr double w[nVels] = {4.0 / 9.0, 1.0 / 9.0, 1.0 / 9.0, 1.0 / 9.0, 1.0 / 9.0,
+			1.0 / 36.0, 1.0 / 36.0, 1.0 / 36.0, 1.0 / 36.0};									// Weightings
+	static constexpr int c[nVels * dims] = {0, 0, 1, 0, -1, 0, 0, 1, 0, -1, 1, 1, -1, -1, 1, -1, -1, 1};	// Direction vectors
+	static constexpr int opposite[nVels] = {0, 2, 1, 4, 3, 6, 5, 8, 7};						// Opposite vectors
+};
+
+// Lattice used by the solver
+typedef D2Q9 Lattice;
+
+// Number of lattice velocities
+const int nVels = Lattice::nVels;
+
+// Alignment of lattice arrays (cache line) and the size large arrays are mapped in (huge page)
+const size_t cacheLine = 64;
+const size_t hugePageSize = 2 * 1024 * 1024;
 
 // IBM support buffer size
 const int suppSize = 9;
 
+// Relative residual, largest residual accepted if that is not reached, iteration limit and iterations without improvement before restarting for sparse IBM epsilon solve
+const double sparseTol = 1e-14;
+const double sparseFailTol = 1e-10;
+const int sparseMaxIt = 1000;
+const int sparseStallIt = 50;
+
+// Block width for AoSoA population layout
+const int blockWidth = 8;
+
+// Number of consecutive sites collided together in SIMD kernel
+const int laneWidth = 8;
+
+// Number of moments stored per site (moment-based storage)
+const int nMoms = 6;
+
+// Number of columns each time step trails the previous one when blocking in time
+const int temporalLag = 4;
+
 // Set default values for 2D beam
 const int nodeDOFs = 3;
 const int elementNodes = 2;
@@ -48,8 +94,12 @@ enum eDirectionType {eX, eY};
 enum eFlexibleType {eFlexible, eRigid};
 enum eBCType {eClamped, eSupported};
 enum eBodyType {eCircle, eFilament};
-enum eLatType {eFluid, eWall, eVelocity, eFreeSlip, ePressure, eConvective};
-enum eProfileType {eParabolic, eShear, eBoundaryLayer};
+enum eLatType {eFluid, eWall, eVelocity, eFreeSlip, ePressure, eConvective, eSolid};
+enum eProfileType {eParabolic, eShear, eBoundaryLayer, eUniform};
+enum eCollisionType {eBGK, eCentralMoments};
+enum eLayoutType {eAoS, eSoA, eAoSoA};
+enum ePrecisionType {eDouble, eFloat, eFloatDelta};
+enum eMomentType {eRho, eJx, eJy, ePxx, ePyy, ePxy};
 
 // Macros
 #define SQ(x) ((x) * (x))
@@ -22,91 +22,118 @@
 // Include defs
 #include "defs.h"
 
+// Build options (the case itself is set at run time in input/case.config)
+
 // Set number of OMP threads (if commented then it will use system max)
 //#define THREADS 12
+//#define PIN_THREADS					// Pin each OMP thread to its own core (spread over the available cores)
 
-// Set resFactor (for easily changing mesh resolution)
-const int resFactor = 2;
+// Memory options for the lattice arrays
+//#define HUGE_PAGES					// Back large lattice arrays with huge pages (explicit if reserved, otherwise transparent)
+//#define NUMA_INTERLEAVE				// Interleave pages of large lattice arrays over the NUMA nodes (instead of first touch)
 
-// Simulation options
-//#define CENTRAL_MOMENTS			// Use central moments collision operator (BGK otherwise)
-#define INLET_RAMP 2.0				// Inlet velocity ramp-up
-//#define WOMERSLEY 5.0				// Womersley number for oscillating pressure gradients
-#define UNI_EPSILON					// Calculate epsilon over all IBM bodies at once
+// Split the lattice into x-slabs over MPI ranks (run with mpirun, OMP threads within each rank)
+//#define MPI_SLABS
+
+// Reduction options
 #define ORDERED						// For deterministic reduction operations
-//#define INITIAL_DEFLECT 0.01		// Set an initial deflection (fraction of L)
+
+// Kernel options
+#define LAYOUT eAoS						// Population storage layout (eAoS, eSoA or eAoSoA)
+#define POP_PRECISION eDouble			// Population storage precision (eDouble, eFloat or eFloatDelta)
+//#define AA_PATTERN					// In-place AA pattern streaming (no f_n copy of the populations)
+//#define HALO							// Pad populations with a ghost layer for periodic streaming
+//#define VECTORISED					// SIMD collision kernels across consecutive sites (runtime dispatch)
+//#define FUSED							// Fused pull kernel (stream, macroscopic and collide in one pass)
+//#define MOMENTS						// Store six moments per site instead of populations (regularised BGK)
+//#define SPARSE						// Store non-solid sites only, numbered in runs up each column (solid mask read from input/solid.pgm)
+//#define LEAN_MEMORY					// Keep start of timestep values at BC sites only and a uniform body force (no per-site force array)
+//#define TILED							// Sweep the lattice in TILE_X by TILE_Y tiles of sites
+#define TILE_X 16						// Tile size in x-direction (lattice sites)
+#define TILE_Y 64						// Tile size in y-direction
+//#define TEMPORAL_STEPS 4				// Time steps per sweep (only used with no IBM bodies or refined patches and non-periodic, non-convective left/right walls)
+
+// IBM options
+//#define LAZY_EPSILON 1e-3				// Keep support and epsilon of a flexible body until a marker moves this far (lattice units)
+
+// Case parameters (read in from input/case.config by readCaseConfig, defaults are in params.cpp)
+
+// Simulation options
+extern eCollisionType collisionType;	// Collision operator (eBGK or eCentralMoments)
+extern double inletRamp;				// Inlet velocity ramp-up time (s, 0 for off)
+extern double womersley;				// Womersley number for oscillating pressure gradients (0 for off)
+extern double smagorinsky;				// Smagorinsky constant for the LES eddy viscosity (0 for off)
+extern bool uniEpsilon;					// Calculate epsilon over all IBM bodies at once
+extern double initialDeflection;		// Set an initial deflection (fraction of L, 0 for off)
 
 // Outputs
-#define VTK								// Write out VTK
-//#define VTK_FEM						// Write out the FEM VTK
-#define FORCES							// Write out forces on structures
-#define TIPS							// Write out tip positions
+extern bool vtkOutput;					// Write out VTK
+extern bool vtkFEMOutput;				// Write out the FEM VTK
+extern bool forcesOutput;				// Write out forces on structures
+extern bool tipsOutput;					// Write out tip positions
 
 // Domain setup (lattice)
-const int Nx = resFactor * 250 + 1;   	// Number of lattice sites in x-direction
-const int Ny = resFactor * 41 + 1;		// Number of lattice sites in y-direction
+extern int Nx;							// Number of lattice sites in x-direction
+extern int Ny;							// Number of lattice sites in y-direction
 
 // Domain setup (physical)
-const double height_p = 0.41;			// Domain height (m)
-const double rho_p = 1000.0;			// Fluid density (kg/m^3)
-const double nu_p = 0.001;				// Fluid kinematic viscosity (m^2/s)
+extern double height_p;					// Domain height (m)
+extern double rho_p;					// Fluid density (kg/m^3)
+extern double nu_p;						// Fluid kinematic viscosity (m^2/s)
 
 // Initial conditions
-const double ux0_p = 0.0;				// Initial x-velocity (m/s)
-const double uy0_p = 0.0;				// Initial y-velocity (m/s)
+extern double ux0_p;					// Initial x-velocity (m/s)
+extern double uy0_p;					// Initial y-velocity (m/s)
 
 // Gravity and pressure gradient
-const double gravityX = 0.0;			// Gravity component in x-direction (m/s^2)
-const double gravityY = 0.0;			// Gravity component in y-direction (m/s^2)
-const double dpdx = 0.0;				// Pressure gradient in x-direction (Pa/m)
-const double dpdy = 0.0;				// Pressure gradient in x-direction (Pa/m)
-
-// Boundary conditions (set to eFluid for periodic)
-#define WALL_LEFT	eVelocity			// Boundary condition at left wall
-#define WALL_RIGHT	ePressure			// Boundary condition at right wall
-#define WALL_BOTTOM	eWall				// Boundary condition at bottom wall
-#define WALL_TOP	eWall				// Boundary condition at top wall
-#define PROFILE 	eParabolic			// Profile shape (uncomment for uniform)
+extern double gravityX;					// Gravity component in x-direction (m/s^2)
+extern double gravityY;					// Gravity component in y-direction (m/s^2)
+extern double dpdx;						// Pressure gradient in x-direction (Pa/m)
+extern double dpdy;						// Pressure gradient in y-direction (Pa/m)
+
+// Boundary conditions
+extern eLatType wallLeft;				// Boundary condition at left wall (eFluid for periodic)
+extern eLatType wallRight;				// Boundary condition at right wall
+extern eLatType wallBottom;				// Boundary condition at bottom wall
+extern eLatType wallTop;				// Boundary condition at top wall
+extern eProfileType profile;			// Inlet profile shape
 
 // Inlet conditions
-const double uxInlet_p = 1.0;			// Inlet x-velocity (m/s)
-const double uyInlet_p = 0.0;			// Inlet y-velocity (m/s)
+extern double uxInlet_p;				// Inlet x-velocity (m/s)
+extern double uyInlet_p;				// Inlet y-velocity (m/s)
 
 // FEM Newmark integration parameters
-const double alpha = 0.25;				// Alpha parameter
-const double delta = 0.5;				// Delta parameter
+extern double alpha;					// Alpha parameter
+extern double delta;					// Delta parameter
 
 // FSI Coupling parameters
-const double relaxMax = 1.0;			// Relaxation parameter (initial guess)
-const double subTol = 1e-8;				// Tolerance for subiterations
-
-// Set omega by three different methods (comment/uncomment)
-// Set omega directly
-//const double omega = 1.875;
-//const double tStep = pow(1.0 / sqrt(3.0), 2.0) * pow(height_p / (Ny - 1), 2.0) * (1.0 - 0.5 * omega) / (nu_p * omega);
-
-// Set time step
-const double tStep = 0.001 / (resFactor * resFactor);
-const double omega = 1.0 / (nu_p * tStep / (pow(1.0 / sqrt(3.0), 2.0) * pow(height_p / (Ny - 1), 2.0)) + 0.5);
+extern double relaxMax;					// Relaxation parameter (initial guess)
+extern double subTol;					// Tolerance for subiterations
 
-// Set lattice velocity
-//const double uLB = (2.0 / 3.0) * 0.2 * 1.0 / sqrt(3.0);
-//const double omega = 1.0 / (uLB * (Ny-1) / (uxInlet_p * height_p / (3.0 * nu_p)) + 0.5);
+// Time step and relaxation
+extern double tStep;					// Time step (s)
+extern double omega;					// Relaxation frequency
 
 // Number of time steps and how often to write out
-const int nSteps = 500;
-const int tinfo = nSteps / 50;
-const int tVTK = nSteps / 10;
-const int tRestart = nSteps / 5;
+extern int nSteps;						// Number of time steps
+extern int tinfo;						// Frequency to write out info and logs
+extern int tVTK;						// Frequency to write out VTK
+extern int tRestart;					// Frequency to write out restart files (0 for off)
 
 // Reference values
-const double ref_nu = nu_p;			// Reference kinematic viscosity (m^2/s)
-const double ref_rho = rho_p;		// Reference density (kg/m^3)
-const double ref_P = 0.0;			// Reference pressure (Pa)
-const double ref_L = 0.1;			// Reference length (m)
-const double ref_U = uxInlet_p;		// Reference velocity (m/s)
+extern double ref_nu;					// Reference kinematic viscosity (m^2/s)
+extern double ref_rho;					// Reference density (kg/m^3)
+extern double ref_P;					// Reference pressure (Pa)
+extern double ref_L;					// Reference length (m)
+extern double ref_U;					// Reference velocity (m/s)
 
 // Precision for ASCII output
-const int PRECISION = 10;
+extern int PRECISION;
+
+// Read in the case parameters from input/case.config
+void readCaseConfig();
+
+// Write out the value of every case parameter
+void writeCaseConfig(ostream &output);
 
 #endif	// PARAMS_H
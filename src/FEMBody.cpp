@@ -358,9 +358,7 @@ void FEMBodyClass::setInitialDeflection() {
 	double deflect = 0.0;
 
 	// Set initial deflection
-#ifdef INITIAL_DEFLECT
-	deflect = -INITIAL_DEFLECT;
-#endif
+	deflect = -initialDeflection;
 
 	// Get beam properties
 	double E = element[0].E;
@@ -49,8 +49,8 @@ void FEMElementClass::loadVector() {
 		Tsub = {{{T[0][0], T[0][1]},
 				 {T[1][0], T[1][1]}}};
 
-		// Convert force to local coordinates
-		F = Tsub * (((-node->epsilon * 1.0 * forceScale) * node->force) + weight);
+		// Convert force to local coordinates (markers on a refined patch use its mass and time scalings)
+		F = Tsub * (((-node->epsilon * 1.0 * forceScale / (1 << node->level)) * node->force) + weight);
 
 		// Get the nodal values by integrating over range of IB point
 		R[0] = F[0] * 0.5 * L * (0.5 * b - 0.5 * a + 0.25 * SQ(a) - 0.25 * SQ(b));
@@ -21,91 +21,1024 @@
 #include "../inc/Objects.h"
 #include "../inc/Utils.h"
 
+// Lattice descriptor storage (for when the arrays are indexed at run time)
+constexpr double D2Q9::c_s;
+constexpr double D2Q9::w[];
+constexpr int D2Q9::c[];
+constexpr int D2Q9::opposite[];
+constexpr double GridClass::c_s;
+constexpr const double *GridClass::w;
+constexpr const int *GridClass::c;
+constexpr const int *GridClass::opposite;
+
+// Lattice sizes and forcing flags that depend on the case (set when the grid is built)
+int NxPad;
+int NyPad;
+bool xyForce;
+
+// Kernels specialised for each collision operator (indexed by eCollisionType)
+const GridClass::KernelSet GridClass::kernelTable[] = {
+	{&GridClass::solverStep<eBGK>, &GridClass::collideInitial<eBGK>},
+	{&GridClass::solverStep<eCentralMoments>, &GridClass::collideInitial<eCentralMoments>}
+};
+
 // Main solver
 void GridClass::solver() {
 
-	// Do grid kernel (LBM)
-	lbmKernel();
+	// Call the time step kernel for this collision operator
+	(this->*kernels.step)();
+}
+
+// Advance one time step (or several when blocking in time)
+template <eCollisionType CollisionType>
+void GridClass::solverStep() {
+
+	// Advance several time steps in one sweep if there is nothing else to do between them
+#ifdef TEMPORAL_STEPS
+	if (temporalBlocking() == true) {
+		temporalKernel<CollisionType>();
+		return;
+	}
+#endif
+
+	// Start parallel section (one team for the whole time step)
+#pragma omp parallel
+	{
+
+		// Do grid kernel (LBM)
+		lbmKernel<CollisionType>();
+
+		// Advance the refined patches and feed them back to the grid
+		if (patch.empty() == false)
+			patchKernel<CollisionType>(1, true);
+
+		// Do object kernel (IBM + FEM)
+		if (oPtr->hasIBM == true)
+			oPtr->objectKernel();
+
+		// Collide sites that had to wait for the BCs and IBM
+#ifdef FUSED
+		collideDeferred<CollisionType>();
+#endif
+	}
+}
+
+// Main LBM kernel (run by every thread of the solver team)
+template <eCollisionType CollisionType>
+void GridClass::lbmKernel() {
+
+	// Calculate convective speed (on the rank with the outlet)
+	if (wallRight == eConvective && iEnd == Nx)
+		convectiveSpeed();
+
+	// Swap to start of timestep (only one thread)
+#pragma omp single
+	{
+#if defined AA_PATTERN || defined MOMENTS
+		if (wallRight == eConvective) {
+
+			// Keep outlet populations as they are overwritten in place
+			for (int j = 0; j < Ny; j++) {
+				for (int v = 0; v < nVels; v++)
+					f_out[j * nVels + v] = getPop(f, fIdx((Nx - 1) * Ny + j, v), v);
+			}
+		}
+#endif
+#ifdef MOMENTS
+		mom_n.swap(mom);
+#elif !defined AA_PATTERN
+		f_n.swap(f);
+#endif
+#ifndef LEAN_MEMORY
+		u_n.swap(u);
+		rho_n.swap(rho);
+#endif
+
+		// Get sites which must be collided after the BCs and IBM
+#ifdef FUSED
+		buildDeferred();
+#endif
+	}
+
+	// Set forcing if Womersley pressure gradient is used (fused kernel sets it for the next step)
+#ifndef FUSED
+	if (womersley > 0.0) {
+
+		// Same at all points (only one thread)
+#ifdef LEAN_MEMORY
+#pragma omp single
+		womersleyForce(t);
+#else
+
+		// Loop through all points
+#pragma omp for schedule(static)
+		for (int id = idStart; id < idEnd; id++) {
+
+			// Calculate forcing
+			womersleyForce(id, rho_n[id], t);
+		}
+#endif
+	}
+#endif
+
+	// Loop through all points
+#ifdef TILED
+#pragma omp for schedule(static) collapse(2)
+	for (int iTile = iStart; iTile < iEnd; iTile += TILE_X) {
+		for (int jTile = 0; jTile < Ny; jTile += TILE_Y) {
+
+			// Sweep the tile column by column
+			for (int i = iTile; i < min(iTile + TILE_X, iEnd); i++)
+				sweepSites<CollisionType>(i, jTile, min(jTile + TILE_Y, Ny));
+		}
+	}
+#elif defined FUSED
+#pragma omp for schedule(static) collapse(2)
+	for (int i = iStart; i < iEnd; i++) {
+		for (int j = 0; j < Ny; j++) {
+
+			// ID
+			int id = i * Ny + j;
+
+			// Pull, get macroscopic and collide in one go
+			fusedKernel<CollisionType>(i, j, id);
+		}
+	}
+#elif defined MOMENTS
+
+	// Each thread sweeps a contiguous range of columns
+	int nThreads = omp_get_num_threads();
+	int thread = omp_get_thread_num();
+	int iFirst = iStart + ((iEnd - iStart) * thread) / nThreads;
+	int iLast = iStart + ((iEnd - iStart) * (thread + 1)) / nThreads;
+
+	// Rebuild the columns either side of the first one (each column is rebuilt once per thread and kept for the next two)
+	double *fCols = &fColumns[thread * 3 * Ny * nVels];
+	if (iFirst < iLast) {
+		projectColumn((iFirst - 1 + Nx) % Nx, &fCols[((iFirst + 2) % 3) * Ny * nVels]);
+		projectColumn(iFirst, &fCols[(iFirst % 3) * Ny * nVels]);
+	}
+
+	// Loop through columns
+	for (int i = iFirst; i < iLast; i++) {
+
+		// Rebuild the next column downstream
+		projectColumn((i + 1) % Nx, &fCols[((i + 1) % 3) * Ny * nVels]);
+
+		// Columns to the left, at and to the right of this one
+		const double *fNbr[3] = {&fCols[((i + 2) % 3) * Ny * nVels], &fCols[(i % 3) * Ny * nVels], &fCols[((i + 1) % 3) * Ny * nVels]};
+
+		// Pull populations from the rebuilt columns and store new moments
+		for (int j = 0; j < Ny; j++)
+			pullMoments(j, i * Ny + j, fNbr);
+	}
+#pragma omp barrier
+#elif defined VECTORISED
+#pragma omp for schedule(static)
+	for (int i = iStart; i < iEnd; i++)
+		sweepSites<CollisionType>(i, 0, Ny);
+#elif defined SPARSE
+
+	// Each thread sweeps a contiguous range of columns
+	int nThreads = omp_get_num_threads();
+	int thread = omp_get_thread_num();
+	int iFirst = iStart + ((iEnd - iStart) * thread) / nThreads;
+	int iLast = iStart + ((iEnd - iStart) * (thread + 1)) / nThreads;
+
+	// Get site IDs of the columns either side of the first one (each column is expanded from its runs once per thread and kept for the next two)
+	int *idCols = &sparseColumns[thread * 3 * Ny];
+	if (iFirst < iLast) {
+		sparseColumn((iFirst - 1 + Nx) % Nx, &idCols[((iFirst + 2) % 3) * Ny]);
+		sparseColumn(iFirst, &idCols[(iFirst % 3) * Ny]);
+	}
+
+	// Loop through columns
+	for (int i = iFirst; i < iLast; i++) {
+
+		// Get site IDs of the next column downstream
+		sparseColumn((i + 1) % Nx, &idCols[((i + 1) % 3) * Ny]);
+
+		// Columns to the left, at and to the right of this one
+		const int *idNbr[3] = {&idCols[((i + 2) % 3) * Ny], &idCols[(i % 3) * Ny], &idCols[((i + 1) % 3) * Ny]};
+
+		// Stream and collide the runs of non-solid sites up the column
+		for (int r = sparseCol[i]; r < sparseCol[i + 1]; r++) {
+			for (int j = sparseRun[r][0]; j < sparseRun[r][1]; j++)
+				streamCollideSparse<CollisionType>(j, sparseRun[r][2] + j - sparseRun[r][0], idNbr);
+		}
+	}
+#pragma omp barrier
+#else
+#pragma omp for schedule(static) collapse(2)
+	for (int i = iStart; i < iEnd; i++) {
+		for (int j = 0; j < Ny; j++) {
+
+			// ID
+			int id = siteIdx(i, j);
+
+			// Stream and collide in one go
+			streamCollide<CollisionType>(i, j, id);
+		}
+	}
+#endif
+
+	// Copy populations from the ghost layer to their periodic images
+#ifdef HALO
+#pragma omp for schedule(static)
+	for (size_t h = 0; h < haloVec.size(); h++)
+		f[haloVec[h][1]] = f[haloVec[h][0]];
+#endif
+
+	// Send populations streamed across the slab edges to the neighbouring ranks (only one thread)
+	if (nRanks > 1) {
+#pragma omp single
+		exchangePops();
+	}
+
+	// Populations are now swapped (or back in place) for the AA pattern
+#ifdef AA_PATTERN
+#pragma omp single
+	aaSwapped = !aaSwapped;
+#endif
+
+	// Loop through all points (already done by fused kernel and moment storage)
+#if !defined FUSED && !defined MOMENTS
+#pragma omp for schedule(static)
+	for (int id = idStart; id < idEnd; id++) {
+
+		// Update fluid site macroscopic values
+		if (type[id] == eFluid)
+			macroscopic(id);
+	}
+#endif
+
+	// Apply BCs before getting macroscopic on all BC sites
+	boundaryKernel<CollisionType>();
+
+	// Get density and velocity next to the slab edges for the IBM interpolation (only one thread)
+	if (nRanks > 1 && oPtr->hasIBM == true) {
+#pragma omp single
+		exchangeMacroscopic();
+	}
+}
+
+#ifdef TEMPORAL_STEPS
+// Advance several time steps per sweep (each thread takes a range of columns through all the steps while its inner edges move in, then the gaps left between the ranges are filled in)
+template <eCollisionType CollisionType>
+void GridClass::temporalKernel() {
+
+	// Get number of steps (stop at the next output step so it sees the right data)
+	int tStart = t;
+	int nSub = 1;
+	while (nSub < TEMPORAL_STEPS && tStart + nSub - 1 < tOffset + nSteps && (tStart + nSub - 1) % tinfo != 0 && (tStart + nSub - 1) % tVTK != 0 && !(tRestart > 0 && (tStart + nSub - 1) % tRestart == 0))
+		nSub++;
+
+	// Number of column ranges (wide enough that the gaps between them never meet)
+	int nRanges = max(1, min(omp_get_max_threads(), Nx / (2 * temporalLag * nSub + 8)));
+
+	// Swap to start of timestep (each step then copies its columns back once they are finished)
+	f_n.swap(f);
+	u_n.swap(u);
+	rho_n.swap(rho);
+
+	// Start parallel section
+#pragma omp parallel
+	{
+
+		// Take each range through all the steps (edges next to another range move in by temporalLag columns per step)
+#pragma omp for schedule(static)
+		for (int r = 0; r < nRanges; r++) {
+
+			// Columns of the range and which edges move in
+			int iFirst = (Nx * r) / nRanges;
+			int iLast = (Nx * (r + 1)) / nRanges;
+			int inLeft = (r > 0 ? 1 : 0);
+			int inRight = (r < nRanges - 1 ? 1 : 0);
+
+			// Sweep a front through the range (each step trails the previous one by temporalLag columns)
+			for (int front = iFirst; front < iLast + temporalLag * (nSub - 1) + 3; front++) {
+				for (int s = 0; s < nSub; s++) {
+
+					// Columns of the range this step can stream (macroscopic needs one more column either side and BCs three)
+					int iLow = iFirst + inLeft * temporalLag * s;
+					int iHigh = iLast - inRight * temporalLag * s;
+
+					// Stream this column, then get macroscopic and apply BCs on the columns trailing it
+					int i = front - temporalLag * s;
+					if (i >= iLow && i < iHigh)
+						temporalStream<CollisionType>(i, tStart + s);
+					if (i - 1 >= iLow + inLeft && i - 1 < iHigh - inRight)
+						temporalMacroscopic(i - 1);
+					if (i - 3 >= iLow + 3 * inLeft && i - 3 < iHigh - 3 * inRight)
+						temporalBoundary<CollisionType>(i - 3, tStart + s, s < nSub - 1);
+				}
+			}
+		}
+
+		// Fill in the gap between each pair of ranges step by step (it widens by temporalLag columns either side per step)
+#pragma omp for schedule(static)
+		for (int r = 1; r < nRanges; r++) {
+			int iEdge = (Nx * r) / nRanges;
+			for (int s = 0; s < nSub; s++) {
+				int gap = temporalLag * s;
+				for (int i = iEdge - gap; i < iEdge + gap; i++)
+					temporalStream<CollisionType>(i, tStart + s);
+				for (int i = iEdge - gap - 1; i < iEdge + gap + 1; i++)
+					temporalMacroscopic(i);
+				for (int i = iEdge - gap - 3; i < iEdge + gap + 3; i++)
+					temporalBoundary<CollisionType>(i, tStart + s, s < nSub - 1);
+			}
+		}
+	}
+
+	// Set time step to the last one done
+	t = tStart + nSub - 1;
+}
+
+// Stream and collide a column of a step (edge columns must not wrap into the opposite wall, which can be at another step)
+template <eCollisionType CollisionType>
+void GridClass::temporalStream(int i, int tStep) {
+
+	// Set forcing if Womersley pressure gradient is used
+	if (womersley > 0.0) {
+		for (int j = 0; j < Ny; j++)
+			womersleyForce(siteIdx(i, j), rho_n[siteIdx(i, j)], tStep);
+	}
+
+	// Stream and collide
+	if (i == 0 || i == Nx - 1) {
+		for (int j = 0; j < Ny; j++)
+			streamCollideClipped<CollisionType>(i, j, siteIdx(i, j));
+	}
+	else {
+		sweepSites<CollisionType>(i, 0, Ny);
+	}
+}
+
+// Update fluid site macroscopic values of a column
+void GridClass::temporalMacroscopic(int i) {
+
+	// Loop through the column
+	for (int j = 0; j < Ny; j++) {
+		int id = siteIdx(i, j);
+		if (type[id] == eFluid)
+			macroscopic(id);
+	}
+}
+
+// Apply BCs of a column and copy it to the start of timestep arrays for the next step (if there is one)
+template <eCollisionType CollisionType>
+void GridClass::temporalBoundary(int i, int tStep, bool keep) {
+
+	// Apply boundary condition and update macroscopic
+	double rampCoefficient = getRampCoefficient(tStep);
+	for (int j = 0; j < Ny; j++) {
+		int id = siteIdx(i, j);
+		if (BCPos[id] >= 0) {
+			applyBCs<CollisionType>(BCPos[id], rampCoefficient);
+			macroscopic(id);
+		}
+	}
+
+	// Copy the finished column
+	if (keep == true) {
+		for (int j = 0; j < Ny; j++) {
+			int id = siteIdx(i, j);
+			for (int v = 0; v < nVels; v++)
+				f_n[popIdx(id, v)] = f[popIdx(id, v)];
+			rho_n[id] = rho[id];
+			u_n[id * dims + eX] = u[id * dims + eX];
+			u_n[id * dims + eY] = u[id * dims + eY];
+		}
+	}
+}
+
+// Check if several time steps can be advanced per sweep
+bool GridClass::temporalBlocking() {
+
+	// Objects, refined patches and the convective outlet need the whole lattice between steps
+	if (oPtr->hasIBM == true || patch.empty() == false || wallRight == eConvective)
+		return false;
+
+	// Left and right walls must be boundary sites (not periodic)
+	for (int j = 0; j < Ny; j++) {
+		if (type[siteIdx(0, j)] == eFluid || type[siteIdx(Nx - 1, j)] == eFluid)
+			return false;
+	}
+	return true;
+}
+#endif
+
+// Stream and collide a run of consecutive sites in a column
+template <eCollisionType CollisionType>
+inline void GridClass::sweepSites(int i, int jStart, int jEnd) {
+
+	// Site ID of the bottom of the column
+	int idCol = siteIdx(i, 0);
+
+	// Loop through sites
+#ifdef FUSED
+	for (int j = jStart; j < jEnd; j++)
+		fusedKernel<CollisionType>(i, j, idCol + j);
+#elif defined VECTORISED
+
+	// Groups of consecutive sites
+	int j = jStart;
+	for (; j + laneWidth <= jEnd; j += laneWidth)
+		streamCollideLanes<CollisionType>(i, j, idCol + j);
+
+	// Remainder
+	for (; j < jEnd; j++)
+		streamCollide<CollisionType>(i, j, idCol + j);
+#else
+	for (int j = jStart; j < jEnd; j++)
+		streamCollide<CollisionType>(i, j, idCol + j);
+#endif
+}
+
+// Stream and collide in one go (push algorithm or AA pattern)
+template <eCollisionType CollisionType>
+inline void GridClass::streamCollide(int i, int j, int id) {
+
+	// Declare populations
+	array<double, nVels> fPop;
+
+	// Read in, collide and stream
+	readPops(id, fPop);
+	collide<CollisionType>(id, fPop);
+	writePops(i, j, fPop);
+}
+
+#ifdef TEMPORAL_STEPS
+// Stream and collide without wrapping in x (populations leaving through the walls are unknowns set by the BCs)
+template <eCollisionType CollisionType>
+void GridClass::streamCollideClipped(int i, int j, int id) {
+
+	// Declare populations
+	array<double, nVels> fPop;
+
+	// Read in and collide
+	readPops(id, fPop);
+	collide<CollisionType>(id, fPop);
+
+	// Push to neighbours inside the lattice
+	for (int v = 0; v < nVels; v++) {
+		int iRecv = i + c[v * dims + eX];
+		if (iRecv >= 0 && iRecv < Nx)
+			setPop(f, popIdx(siteIdx(iRecv, (j + c[v * dims + eY] + Ny) % Ny), v), v, fPop[v]);
+	}
+}
+#endif
+
+// Stream and collide at a non-solid site (sparse lattice)
+#ifdef SPARSE
+template <eCollisionType CollisionType>
+inline void GridClass::streamCollideSparse(int j, int id, const int *const idNbr[3]) {
+
+	// Declare populations
+	array<double, nVels> fPop;
+
+	// Read in and collide
+	readPops(id, fPop);
+	collide<CollisionType>(id, fPop);
+
+	// Get receiving site of each population (no wrapping in y away from edges)
+	array<int, nVels> recv;
+	if (j > 0 && j < Ny - 1) {
+		for (int v = 0; v < nVels; v++)
+			recv[v] = idNbr[1 + c[v * dims + eX]][j + c[v * dims + eY]];
+	}
+	else {
+		for (int v = 0; v < nVels; v++)
+			recv[v] = idNbr[1 + c[v * dims + eX]][(j + c[v * dims + eY] + Ny) % Ny];
+	}
+
+	// Push to neighbours (halfway bounce-back into own opposite slot at solid neighbours)
+	for (int v = 0; v < nVels; v++) {
+		if (recv[v] == idEnd)
+			setPop(f, popIdx(id, opposite[v]), opposite[v], fPop[v]);
+		else
+			setPop(f, popIdx(recv[v], v), v, fPop[v]);
+	}
+}
+
+// Get site IDs up a column from its runs of non-solid sites (solid sites get the shared solid site)
+inline void GridClass::sparseColumn(int i, int *idCol) const {
+
+	// Solid unless in a run
+	fill(idCol, idCol + Ny, idEnd);
+	for (int r = sparseCol[i]; r < sparseCol[i + 1]; r++) {
+		for (int j = sparseRun[r][0]; j < sparseRun[r][1]; j++)
+			idCol[j] = sparseRun[r][2] + j - sparseRun[r][0];
+	}
+}
+#endif
+
+// Stream and collide a group of consecutive sites in one go (SIMD across sites)
+#ifdef VECTORISED
+template <eCollisionType CollisionType>
+__attribute__((target_clones("avx512f", "avx2", "default")))
+void GridClass::streamCollideLanes(int i, int j, int id) {
+
+	// Declare lane arrays
+	array<double, nVels> fPop;
+	double fLane[nVels][laneWidth];
+	double rhoLane[laneWidth], uxLane[laneWidth], uyLane[laneWidth], FxLane[laneWidth], FyLane[laneWidth];
+
+	// Read in populations and macroscopic values
+	for (int l = 0; l < laneWidth; l++) {
+		readPops(id + l, fPop);
+		for (int v = 0; v < nVels; v++)
+			fLane[v][l] = fPop[v];
+		rhoLane[l] = rhoStart(id + l);
+		uxLane[l] = uStart(id + l, eX);
+		uyLane[l] = uStart(id + l, eY);
+	}
+
+	// Get local relaxation frequency of each lane (kept out of the collision loops as LES branches)
+	double omegaLane[laneWidth];
+	for (int l = 0; l < laneWidth; l++)
+		omegaLane[l] = localOmega(rhoLane[l], uxLane[l], uyLane[l], &fLane[0][l], laneWidth, omega);
+
+	// Check if any lane has a force
+	bool forced = false;
+	for (int l = 0; l < laneWidth; l++)
+		forced = forced || isForced(id + l);
+
+	// Collide all lanes together (only read forces if any lane has one)
+	if (forced == true) {
+		for (int l = 0; l < laneWidth; l++) {
+			FxLane[l] = siteForce(id + l, eX) + force_ibm[(id + l) * dims + eX];
+			FyLane[l] = siteForce(id + l, eY) + force_ibm[(id + l) * dims + eY];
+		}
+		if (CollisionType == eCentralMoments) {
+#pragma omp simd
+			for (int l = 0; l < laneWidth; l++)
+				collideCentral(rhoLane[l], uxLane[l], uyLane[l], FxLane[l], FyLane[l], &fLane[0][l], laneWidth, omegaLane[l]);
+		}
+		else {
+			for (int v = 0; v < nVels; v++) {
+#pragma omp simd
+				for (int l = 0; l < laneWidth; l++)
+					fLane[v][l] = fLane[v][l] + omegaLane[l] * (equilibrium<CollisionType>(rhoLane[l], uxLane[l], uyLane[l], v) - fLane[v][l]) + (1.0 - 0.5 * omegaLane[l]) * latticeForce(uxLane[l], uyLane[l], FxLane[l], FyLane[l], v);
+			}
+		}
+	}
+	else {
+		if (CollisionType == eCentralMoments) {
+#pragma omp simd
+			for (int l = 0; l < laneWidth; l++)
+				collideCentral(rhoLane[l], uxLane[l], uyLane[l], 0.0, 0.0, &fLane[0][l], laneWidth, omegaLane[l]);
+		}
+		else {
+			for (int v = 0; v < nVels; v++) {
+#pragma omp simd
+				for (int l = 0; l < laneWidth; l++)
+					fLane[v][l] = fLane[v][l] + omegaLane[l] * (equilibrium<CollisionType>(rhoLane[l], uxLane[l], uyLane[l], v) - fLane[v][l]);
+			}
+		}
+	}
+
+	// Stream
+	for (int l = 0; l < laneWidth; l++) {
+		for (int v = 0; v < nVels; v++)
+			fPop[v] = fLane[v][l];
+		writePops(i, j + l, fPop);
+	}
+}
+#endif
+
+// Pull, compute macroscopic and collide in one go (fused kernel)
+template <eCollisionType CollisionType>
+inline void GridClass::fusedKernel(int i, int j, int id) {
+
+	// Declare populations
+	array<double, nVels> fPop;
+
+	// Pull from neighbours (constant offset away from edges)
+	if (i > 0 && i < Nx - 1 && j > 0 && j < Ny - 1) {
+		for (int v = 0; v < nVels; v++)
+			fPop[v] = getPop(f_n, popIdx(id - shift[v], v), v);
+	}
+	else {
+		for (int v = 0; v < nVels; v++)
+			fPop[v] = getPop(f_n, popIdx(((i - c[v * dims + eX] + Nx) % Nx) * Ny + ((j - c[v * dims + eY] + Ny) % Ny), v), v);
+	}
+
+	// Get macroscopic values
+	macroscopic(id, fPop);
+
+	// Keep post-stream populations if collision must wait for BCs and IBM
+	if (deferPos[id] >= 0) {
+		for (int v = 0; v < nVels; v++)
+			setPop(f, popIdx(id, v), v, fPop[v]);
+		return;
+	}
+
+	// Update forcing for the next step
+	if (womersley > 0.0)
+		womersleyForce(id, rho[id], t + 1);
+
+	// Collide (only read forces if the site has one) and store
+	if (isForced(id) == true) {
+		double Fx = siteForce(id, eX) + force_ibm[id * dims + eX];
+		double Fy = siteForce(id, eY) + force_ibm[id * dims + eY];
+		collideSite<CollisionType>(rho[id], u[id * dims + eX], u[id * dims + eY], Fx, Fy, fPop.data(), 1);
+	}
+	else {
+		collideSiteUnforced<CollisionType>(rho[id], u[id * dims + eX], u[id * dims + eY], fPop.data(), 1);
+	}
+	for (int v = 0; v < nVels; v++)
+		setPop(f, popIdx(id, v), v, fPop[v]);
+}
+
+// Collide post-stream populations in place using current macroscopic values (fused kernel)
+template <eCollisionType CollisionType>
+inline void GridClass::collideInPlace(int id) {
+
+	// Read in populations
+	array<double, nVels> fPop;
+	for (int v = 0; v < nVels; v++)
+		fPop[v] = getPop(f, popIdx(id, v), v);
+
+	// Keep outlet populations for convective BC
+	if (type[id] == eConvective) {
+		for (int v = 0; v < nVels; v++)
+			f_out[(id - (Nx - 1) * Ny) * nVels + v] = fPop[v];
+	}
+
+	// Update forcing for the next step
+	if (womersley > 0.0)
+		womersleyForce(id, rho[id], t + 1);
+
+	// Collide (only read forces if the site has one) and store
+	if (isForced(id) == true) {
+		double Fx = siteForce(id, eX) + force_ibm[id * dims + eX];
+		double Fy = siteForce(id, eY) + force_ibm[id * dims + eY];
+		collideSite<CollisionType>(rho[id], u[id * dims + eX], u[id * dims + eY], Fx, Fy, fPop.data(), 1);
+	}
+	else {
+		collideSiteUnforced<CollisionType>(rho[id], u[id * dims + eX], u[id * dims + eY], fPop.data(), 1);
+	}
+	for (int v = 0; v < nVels; v++)
+		setPop(f, popIdx(id, v), v, fPop[v]);
+}
+
+// Build list of sites which must be collided after the BCs and IBM (fused kernel)
+void GridClass::buildDeferred() {
+
+	// Remove IBM sites from last step (BC sites are always kept at the start)
+	for (size_t d = BCVec.size(); d < deferVec.size(); d++)
+		deferPos[deferVec[d]] = -1;
+	deferVec.resize(BCVec.size());
+
+	// Add IBM support sites (dilated by one site as markers can move during the step)
+	if (oPtr->hasIBM == true) {
+
+		// Get support sites
+		vector<int> suppVec;
+		oPtr->getSupportSites(suppVec);
+
+		// Loop through and add neighbourhood
+		for (size_t s = 0; s < suppVec.size(); s++) {
+			int i = suppVec[s] / Ny;
+			int j = suppVec[s] - i * Ny;
+			for (int v = 0; v < nVels; v++) {
+				int id = ((i + c[v * dims + eX] + Nx) % Nx) * Ny + ((j + c[v * dims + eY] + Ny) % Ny);
+				if (deferPos[id] < 0) {
+					deferPos[id] = static_cast<int>(deferVec.size());
+					deferVec.push_back(id);
+				}
+			}
+		}
+	}
+
+	// Resize post-stream store
+	fDefer.resize(deferVec.size() * nVels);
+}
+
+// Collide sites that had to wait for the BCs and IBM (fused kernel)
+template <eCollisionType CollisionType>
+void GridClass::collideDeferred() {
+
+	// Check the IBM support has not moved outside the deferred sites (only one thread)
+#pragma omp single
+	if (oPtr->hasIBM == true) {
+
+		// Get support sites
+		vector<int> suppVec;
+		oPtr->getSupportSites(suppVec);
+
+		// Check each one
+		for (size_t s = 0; s < suppVec.size(); s++) {
+			if (deferPos[suppVec[s]] < 0)
+				ERROR("IBM support moved more than one lattice site in a time step (t = " + to_string(t) + ")...exiting");
+		}
+	}
+
+	// Loop through deferred sites
+#pragma omp for schedule(guided)
+	for (size_t d = 0; d < deferVec.size(); d++) {
+
+		// Keep post-stream populations (for restart files)
+		int id = deferVec[d];
+		for (int v = 0; v < nVels; v++)
+			fDefer[d * nVels + v] = getPop(f, popIdx(id, v), v);
+
+		// Collide
+		collideInPlace<CollisionType>(id);
+	}
+}
+
+// Collide all sites to start the fused kernel
+template <eCollisionType CollisionType>
+void GridClass::collideInitial() {
+
+	// Loop through all sites
+#pragma omp parallel for schedule(static)
+	for (int id = idStart; id < idEnd; id++)
+		collideInPlace<CollisionType>(id);
+}
+
+// Get post-stream populations at a site
+void GridClass::getPostStream(int i, int j, int id, array<double, nVels> &fPop) {
+
+#ifdef FUSED
+
+	// Deferred sites kept their post-stream populations
+	if (deferPos[id] >= 0) {
+		for (int v = 0; v < nVels; v++)
+			fPop[v] = fDefer[deferPos[id] * nVels + v];
+	}
+
+	// Otherwise pull post-collision populations from neighbours
+	else {
+		for (int v = 0; v < nVels; v++)
+			fPop[v] = getPop(f_n, popIdx(((i - c[v * dims + eX] + Nx) % Nx) * Ny + ((j - c[v * dims + eY] + Ny) % Ny), v), v);
+	}
+#else
+
+	// Current populations (rebuilt from the moments away from BC sites)
+	(void)i;
+	(void)j;
+#ifdef MOMENTS
+	if (BCPos[id] < 0) {
+		for (int v = 0; v < nVels; v++)
+			fPop[v] = projectMoments(&mom[id * nMoms], v);
+		return;
+	}
+#endif
+
+	// Solid sites hold no populations
+#ifdef SPARSE
+	if (type[id] == eSolid) {
+		fPop.fill(0.0);
+		return;
+	}
+#endif
+	for (int v = 0; v < nVels; v++)
+		fPop[v] = getPop(f, fIdx(id, v), v);
+#endif
+}
+
+// Set post-stream populations at a site (stored as moments away from BC sites)
+void GridClass::putPostStream(int id, const array<double, nVels> &fPop) {
+
+	// Store moments
+#ifdef MOMENTS
+	setMoments(id, fPop);
+	if (BCPos[id] < 0)
+		return;
+#endif
+
+	// Solid sites hold no populations
+#ifdef SPARSE
+	if (type[id] == eSolid)
+		return;
+#endif
+
+	// Store populations
+	for (int v = 0; v < nVels; v++)
+		setPop(f, fIdx(id, v), v, fPop[v]);
+}
+
+// Pull post-collision populations from the rebuilt columns and store their moments
+#ifdef MOMENTS
+inline void GridClass::pullMoments(int j, int id, const double *const fNbr[3]) {
+
+	// Declare populations
+	array<double, nVels> fPop;
+
+	// Pull from the upstream column and row (no wrapping in y away from edges)
+	if (j > 0 && j < Ny - 1) {
+		for (int v = 0; v < nVels; v++)
+			fPop[v] = fNbr[1 - c[v * dims + eX]][(j - c[v * dims + eY]) * nVels + v];
+	}
+	else {
+		for (int v = 0; v < nVels; v++)
+			fPop[v] = fNbr[1 - c[v * dims + eX]][((j - c[v * dims + eY] + Ny) % Ny) * nVels + v];
+	}
+
+	// Fluid sites only need their moments and macroscopic values
+	if (type[id] == eFluid) {
+		setMoments(id, fPop);
+		macroscopic(id, fPop);
+	}
+
+	// BC sites keep their populations for the BCs
+	else {
+		for (int v = 0; v < nVels; v++)
+			setPop(f, popIdx(id, v), v, fPop[v]);
+	}
+}
+
+// Collide the moments of a column and rebuild all its post-collision populations
+inline void GridClass::projectColumn(int i, double *fCol) {
+
+	// Loop through the column
+	for (int j = 0; j < Ny; j++) {
+
+		// Collide
+		double m[nMoms];
+		collideMoments(i * Ny + j, m);
+
+		// Rebuild populations
+		for (int v = 0; v < nVels; v++)
+			fCol[j * nVels + v] = projectMoments(m, v);
+	}
+}
+
+// Collide start of timestep moments (regularised BGK with forcing moments)
+inline void GridClass::collideMoments(int id, double *m) {
+
+	// Get site values
+	for (int k = 0; k < nMoms; k++)
+		m[k] = mom_n[id * nMoms + k];
+	double rhoSite = rhoStart(id);
+	double ux = uStart(id, eX);
+	double uy = uStart(id, eY);
+
+	// Get local relaxation frequency
+	double omegaSite = (smagorinsky > 0.0 ? eddyOmega(rhoSite, ux, uy, m[ePxx], m[ePyy], m[ePxy], omega) : omega);
+
+	// Relax towards equilibrium moments (no force moments if the site has no force)
+	if (isForced(id) == false) {
+		m[eRho] += omegaSite * (rhoSite - m[eRho]);
+		m[eJx] += omegaSite * (rhoSite * ux - m[eJx]);
+		m[eJy] += omegaSite * (rhoSite * uy - m[eJy]);
+		m[ePxx] += omegaSite * (rhoSite * (1.0 / 3.0 + ux * ux) - m[ePxx]);
+		m[ePyy] += omegaSite * (rhoSite * (1.0 / 3.0 + uy * uy) - m[ePyy]);
+		m[ePxy] += omegaSite * (rhoSite * ux * uy - m[ePxy]);
+		return;
+	}
+
+	// Get total force
+	double Fx = siteForce(id, eX) + force_ibm[id * dims + eX];
+	double Fy = siteForce(id, eY) + force_ibm[id * dims + eY];
+
+	// Relax towards equilibrium moments and add force moments
+	m[eRho] += omegaSite * (rhoSite - m[eRho]);
+	m[eJx] += omegaSite * (rhoSite * ux - m[eJx]) + (1.0 - 0.5 * omegaSite) * Fx;
+	m[eJy] += omegaSite * (rhoSite * uy - m[eJy]) + (1.0 - 0.5 * omegaSite) * Fy;
+	m[ePxx] += omegaSite * (rhoSite * (1.0 / 3.0 + ux * ux) - m[ePxx]) + (1.0 - 0.5 * omegaSite) * 2.0 * ux * Fx;
+	m[ePyy] += omegaSite * (rhoSite * (1.0 / 3.0 + uy * uy) - m[ePyy]) + (1.0 - 0.5 * omegaSite) * 2.0 * uy * Fy;
+	m[ePxy] += omegaSite * (rhoSite * ux * uy - m[ePxy]) + (1.0 - 0.5 * omegaSite) * (ux * Fy + uy * Fx);
+}
+
+// Get population v from the stored moments (second order Hermite expansion)
+inline double GridClass::projectMoments(const double *m, int v) const {
+
+	// Extract required quantities
+	int cx = c[v * dims + eX];
+	int cy = c[v * dims + eY];
+
+	// Expand (c_s^2 = 1/3)
+	return w[v] * (m[eRho] + 3.0 * (cx * m[eJx] + cy * m[eJy])
+			+ 4.5 * ((SQ(cx) - 1.0 / 3.0) * (m[ePxx] - m[eRho] / 3.0) + (SQ(cy) - 1.0 / 3.0) * (m[ePyy] - m[eRho] / 3.0) + 2.0 * cx * cy * m[ePxy]));
+}
+
+// Store moments of the populations at a site
+inline void GridClass::setMoments(int id, const array<double, nVels> &fPop) {
+
+	// Reset
+	double m[nMoms] = {0.0};
+
+	// Sum up
+	for (int v = 0; v < nVels; v++) {
+		m[eRho] += fPop[v];
+		m[eJx] += c[v * dims + eX] * fPop[v];
+		m[eJy] += c[v * dims + eY] * fPop[v];
+		m[ePxx] += c[v * dims + eX] * c[v * dims + eX] * fPop[v];
+		m[ePyy] += c[v * dims + eY] * c[v * dims + eY] * fPop[v];
+		m[ePxy] += c[v * dims + eX] * c[v * dims + eY] * fPop[v];
+	}
 
-	// Do object kernel (IBM + FEM)
-	if (oPtr->hasIBM == true)
-		oPtr->objectKernel();
+	// Store
+	for (int k = 0; k < nMoms; k++)
+		mom[id * nMoms + k] = m[k];
 }
+#endif
 
-// Main LBM kernel
-void GridClass::lbmKernel() {
+// Read in populations to be collided at a site
+inline void GridClass::readPops(int id, array<double, nVels> &fPop) {
 
-	// Calculate convective speed
-	if (WALL_RIGHT == eConvective)
-		convectiveSpeed();
+#ifdef AA_PATTERN
 
-	// Swap to start of timestep
-	f_n.swap(f);
-	u_n.swap(u);
-	rho_n.swap(rho);
+	// Odd step (populations are swapped so gather from neighbours)
+	if (aaSwapped) {
+		for (int v = 0; v < nVels; v++)
+			fPop[v] = getPop(f, fIdx(id, v), v);
+	}
 
-	// Start parallel section
-#pragma omp parallel
-	{
+	// Even step (read in place)
+	else {
+		for (int v = 0; v < nVels; v++)
+			fPop[v] = getPop(f, popIdx(id, v), v);
+	}
+#else
 
-		// Set forcing if Womersley pressure gradient is used
-#ifdef WOMERSLEY
+	// Start of timestep populations
+	for (int v = 0; v < nVels; v++)
+		fPop[v] = getPop(f_n, popIdx(id, v), v);
+#endif
+}
 
-		// Loop through all points
-#pragma omp for schedule(guided)
-		for (int id = 0; id < Nx * Ny; id++) {
+// Stream post-collision populations from a site
+inline void GridClass::writePops(int i, int j, array<double, nVels> &fPop) {
 
-			// Calculate forcing
-			force_xy[id * dims + eX] = (rho_n[id] * Drho * gravityX + dpdx * cos(2.0 * M_PI * t * Dt / ((SQ(height_p) * M_PI) / (2.0 * SQ(WOMERSLEY) * nu_p)))) * SQ(Dx * Dt) / Dm;
-			force_xy[id * dims + eY] = (rho_n[id] * Drho * gravityY + dpdy * cos(2.0 * M_PI * t * Dt / ((SQ(height_p) * M_PI) / (2.0 * SQ(WOMERSLEY) * nu_p)))) * SQ(Dx * Dt) / Dm;
-		}
-#endif
+#ifdef AA_PATTERN
 
-		// Loop through all points
-#pragma omp for schedule(guided) collapse(2)
-		for (int i = 0; i < Nx; i++) {
-			for (int j = 0; j < Ny; j++) {
+	// Odd step (scatter to neighbours)
+	if (aaSwapped) {
+		for (int v = 0; v < nVels; v++)
+			setPop(f, popIdx(((i + c[v * dims + eX] + Nx) % Nx) * Ny + ((j + c[v * dims + eY] + Ny) % Ny), v), v, fPop[v]);
+	}
 
-				// ID
-				int id = i * Ny + j;
+	// Even step (write back swapped, storing in the opposite slot)
+	else {
+		for (int v = 0; v < nVels; v++)
+			setPop(f, popIdx(i * Ny + j, opposite[v]), opposite[v], fPop[v]);
+	}
+#elif defined HALO
 
-				// Stream and collide in one go
-				streamCollide(i, j, id);
-			}
-		}
+	// Constant offset (edge sites push into the ghost layer)
+	int sid = (i + 1) * NyPad + j + 1;
+	for (int v = 0; v < nVels; v++)
+		setPop(f, layoutIdx(sid + shift[v], v), v, fPop[v]);
+#else
 
-		// Loop through all points
-#pragma omp for schedule(guided)
-		for (int id = 0; id < Nx * Ny; id++) {
+	// Push to neighbours
+	for (int v = 0; v < nVels; v++) {
 
-			// Update fluid site macroscopic values
-			if (type[id] == eFluid)
-				macroscopic(id);
-		}
+		// Calculate newx and newy then stream
+		int recv_id = siteIdx((i + c[v * dims + eX] + Nx) % Nx, (j + c[v * dims + eY] + Ny) % Ny);
 
-		// Loop through all BC sites and apply BCs before getting macroscopic
-#pragma omp for schedule(guided)
-		for (size_t bc = 0; bc < BCVec.size(); bc++) {
+		// Update new f
+		setPop(f, popIdx(recv_id, v), v, fPop[v]);
+	}
+#endif
+}
 
-			// ID
-			int id = BCVec[bc];
-			int i = id / Ny;
-			int j = id - (i * Ny);
+// Collide populations at a site (overwritten with post-collision)
+template <eCollisionType CollisionType>
+inline void GridClass::collide(int id, array<double, nVels> &fPop) {
 
-			// Apply boundary condition and update macroscopic
-			applyBCs(i, j, id);
-			macroscopic(id);
-		}
+	// Collide without reading forces if the site has none
+	if (isForced(id) == false) {
+		collideSiteUnforced<CollisionType>(rhoStart(id), uStart(id, eX), uStart(id, eY), fPop.data(), 1);
+		return;
 	}
+
+	// Get total force
+	double Fx = siteForce(id, eX) + force_ibm[id * dims + eX];
+	double Fy = siteForce(id, eY) + force_ibm[id * dims + eY];
+
+	// Collide
+	collideSite<CollisionType>(rhoStart(id), uStart(id, eX), uStart(id, eY), Fx, Fy, fPop.data(), 1);
 }
 
-// Stream and collide in one go (push algorithm)
-inline void GridClass::streamCollide(int i, int j, int id) {
+// Collide populations given the site values (overwritten with post-collision, stored every stride values)
+template <eCollisionType CollisionType>
+__attribute__((always_inline)) inline void GridClass::collideSite(double rho, double ux, double uy, double Fx, double Fy, double *fPop, int stride, double omegaSite) const {
 
-	// Stream and collide
-#ifdef CENTRAL_MOMENTS
+	// Get local relaxation frequency
+	omegaSite = localOmega(rho, ux, uy, fPop, stride, omegaSite);
+
+	// BGK
+	if (CollisionType == eBGK) {
+		for (int v = 0; v < nVels; v++)
+			fPop[v * stride] = fPop[v * stride] + omegaSite * (equilibrium<CollisionType>(rho, ux, uy, v) - fPop[v * stride]) + (1.0 - 0.5 * omegaSite) * latticeForce(ux, uy, Fx, Fy, v);
+		return;
+	}
 
 	// Central moments
+	collideCentral(rho, ux, uy, Fx, Fy, fPop, stride, omegaSite);
+}
+
+// Collide populations with the central moments operator given the site values and relaxation frequency (no branches so lanes of sites vectorise)
+__attribute__((always_inline)) inline void GridClass::collideCentral(double rho, double ux, double uy, double Fx, double Fy, double *fPop, int stride, double omegaSite) const {
+
+	// Get pre-collision central moments
 	double k4Pre = 0.0;
 	double k5Pre = 0.0;
 
@@ -113,34 +1046,27 @@ inline void GridClass::streamCollide(int i, int j, int id) {
 	for (int v = 0; v < nVels; v++) {
 
 		// Shift lattice velocities
-		double cx = c[v * dims + eX] - u_n[id * dims + eX];
-		double cy = c[v * dims + eY] - u_n[id * dims + eY];
+		double cx = c[v * dims + eX] - ux;
+		double cy = c[v * dims + eY] - uy;
 
 		// Transform f to central moments (k)
-		k4Pre += f_n[id * nVels + v] * (SQ(cx) - SQ(cy));
-		k5Pre += f_n[id * nVels + v] * cx * cy;
+		k4Pre += fPop[v * stride] * (SQ(cx) - SQ(cy));
+		k5Pre += fPop[v * stride] * cx * cy;
 	}
 
 	// Get post-collision central moments
-	double k0 = rho_n[id];
-	double k1 = 0.5 * (force_xy[id * dims + eX] + force_ibm[id * dims + eX]);
-	double k2 = 0.5 * (force_xy[id * dims + eY] + force_ibm[id * dims + eY]);
-	double k3 = 2.0 * rho_n[id] * SQ(c_s);
-	double k4 = (1.0 - omega) * k4Pre;
-	double k5 = (1.0 - omega) * k5Pre;
-	double k6 = 0.5 * (force_xy[id * dims + eY] + force_ibm[id * dims + eY]) * SQ(c_s);
-	double k7 = 0.5 * (force_xy[id * dims + eX] + force_ibm[id * dims + eX]) * SQ(c_s);
-	double k8 = rho_n[id] * QU(c_s);
-
-	// Get velocity
-	double ux = u_n[id * dims + eX];
-	double uy = u_n[id * dims + eY];
-
-	// Declare array
-	array<double, nVels> fStar;
-
-	// Set array (transform from central moments to f)
-	fStar[0] = (SQ(ux) * SQ(uy) - SQ(ux) - SQ(uy) + 1.0) * k0
+	double k0 = rho;
+	double k1 = 0.5 * Fx;
+	double k2 = 0.5 * Fy;
+	double k3 = 2.0 * rho * SQ(c_s);
+	double k4 = (1.0 - omegaSite) * k4Pre;
+	double k5 = (1.0 - omegaSite) * k5Pre;
+	double k6 = 0.5 * Fy * SQ(c_s);
+	double k7 = 0.5 * Fx * SQ(c_s);
+	double k8 = rho * QU(c_s);
+
+	// Set post-collision populations (transform from central moments to f)
+	fPop[0] = (SQ(ux) * SQ(uy) - SQ(ux) - SQ(uy) + 1.0) * k0
 				+ (2.0 * ux * SQ(uy) - 2.0 * ux) * k1
 				+ (2.0 * uy * SQ(ux) - 2.0 * uy) * k2
 				+ (0.5 * SQ(ux) + 0.5 * SQ(uy) - 1.0) * k3
@@ -149,7 +1075,7 @@ inline void GridClass::streamCollide(int i, int j, int id) {
 				+ 2.0 * uy * k6
 				+ 2.0 * ux * k7
 				+ k8;
-	fStar[1] = (0.5 * SQ(ux) - 0.5 * (SQ(ux) * SQ(uy)) - 0.5 * (ux * SQ(uy)) + 0.5 * ux) * k0
+	fPop[stride] = (0.5 * SQ(ux) - 0.5 * (SQ(ux) * SQ(uy)) - 0.5 * (ux * SQ(uy)) + 0.5 * ux) * k0
 				+ (ux - ux * SQ(uy) - 0.5 * SQ(uy) + 0.5) * k1
 				+ (-uy * SQ(ux) - uy * ux) * k2
 				+ (-0.25 * SQ(ux) - 0.25 * ux - 0.25 * SQ(uy) + 0.25) * k3
@@ -158,7 +1084,7 @@ inline void GridClass::streamCollide(int i, int j, int id) {
 				+ (-uy) * k6
 				+ (-ux - 0.5) * k7
 				- 0.5 * k8;
-	fStar[2] = (-0.5 * (SQ(ux) * SQ(uy)) + 0.5 * SQ(ux) + 0.5 * (ux * SQ(uy)) - 0.5 * ux) * k0
+	fPop[2 * stride] = (-0.5 * (SQ(ux) * SQ(uy)) + 0.5 * SQ(ux) + 0.5 * (ux * SQ(uy)) - 0.5 * ux) * k0
 				+ (ux - ux * SQ(uy) + 0.5 * SQ(uy) - 0.5) * k1
 				+ (-uy * SQ(ux) + uy * ux) * k2
 				+ (-0.25 * SQ(ux) + 0.25 * ux - 0.25 * SQ(uy) + 0.25) * k3
@@ -167,7 +1093,7 @@ inline void GridClass::streamCollide(int i, int j, int id) {
 				+ (-uy) * k6
 				+ (0.5 - ux) * k7
 				- 0.5 * k8;
-	fStar[3] = (0.5 * SQ(uy) - 0.5 * (SQ(ux) * uy) - 0.5 * (SQ(ux) * SQ(uy)) + 0.5 * uy) * k0
+	fPop[3 * stride] = (0.5 * SQ(uy) - 0.5 * (SQ(ux) * uy) - 0.5 * (SQ(ux) * SQ(uy)) + 0.5 * uy) * k0
 				+ (-ux * SQ(uy) - ux * uy) * k1
 				+ (uy - SQ(ux) * uy - 0.5 * SQ(ux) + 0.5) * k2
 				+ (-0.25 * SQ(ux) - 0.25 * SQ(uy) - 0.25 * uy + 0.25) * k3
@@ -176,7 +1102,7 @@ inline void GridClass::streamCollide(int i, int j, int id) {
 				+ (-uy - 0.5) * k6
 				+ (-ux) * k7
 				- 0.5 * k8;
-	fStar[4] = (-0.5 * (SQ(ux) * SQ(uy)) + 0.5 * (SQ(ux) * uy) + 0.5 * SQ(uy) - 0.5 * uy) * k0
+	fPop[4 * stride] = (-0.5 * (SQ(ux) * SQ(uy)) + 0.5 * (SQ(ux) * uy) + 0.5 * SQ(uy) - 0.5 * uy) * k0
 				+ (-ux * SQ(uy) + ux * uy) * k1
 				+ (uy - SQ(ux) * uy + 0.5 * SQ(ux) - 0.5) * k2
 				+ (-0.25 * SQ(ux) - 0.25 * SQ(uy) + 0.25 * uy + 0.25) * k3
@@ -185,7 +1111,7 @@ inline void GridClass::streamCollide(int i, int j, int id) {
 				+ (0.5 - uy) * k6
 				+ (-ux) * k7
 				- 0.5 * k8;
-	fStar[5] = (0.25 * (SQ(ux) * SQ(uy)) + 0.25 * (SQ(ux) * uy) + 0.25 * (ux * SQ(uy)) + 0.25 * (ux * uy)) * k0
+	fPop[5 * stride] = (0.25 * (SQ(ux) * SQ(uy)) + 0.25 * (SQ(ux) * uy) + 0.25 * (ux * SQ(uy)) + 0.25 * (ux * uy)) * k0
 				+ (0.25 * uy + 0.5 * (ux * uy) + 0.5 * (ux * SQ(uy)) + 0.25 * SQ(uy)) * k1
 				+ (0.25 * ux + 0.5 * (ux * uy) + 0.5 * (SQ(ux) * uy) + 0.25 * SQ(ux)) * k2
 				+ (0.125 * SQ(ux) + 0.125 * ux + 0.125 * SQ(uy) + 0.125 * uy) * k3
@@ -194,7 +1120,7 @@ inline void GridClass::streamCollide(int i, int j, int id) {
 				+ (0.5 * uy + 0.25) * k6
 				+ (0.5 * ux + 0.25) * k7
 				+ 0.25 * k8;
-	fStar[6] = (0.25 * (SQ(ux) * SQ(uy)) - 0.25 * (SQ(ux) * uy) - 0.25 * (ux * SQ(uy)) + 0.25 * (ux * uy)) * k0
+	fPop[6 * stride] = (0.25 * (SQ(ux) * SQ(uy)) - 0.25 * (SQ(ux) * uy) - 0.25 * (ux * SQ(uy)) + 0.25 * (ux * uy)) * k0
 				+ (0.25 * uy - 0.5 * (ux * uy) + 0.5 * (ux * SQ(uy)) - 0.25 * SQ(uy)) * k1
 				+ (0.25 * ux - 0.5 * (ux * uy) + 0.5 * (SQ(ux) * uy) - 0.25 * SQ(ux)) * k2
 				+ (0.125 * SQ(ux) - 0.125 * ux + 0.125 * SQ(uy) - 0.125 * uy) * k3
@@ -203,7 +1129,7 @@ inline void GridClass::streamCollide(int i, int j, int id) {
 				+ (0.5 * uy - 0.25) * k6
 				+ (0.5 * ux - 0.25) * k7
 				+ 0.25 * k8;
-	fStar[7] = (0.25 * (SQ(ux) * SQ(uy)) - 0.25 * (SQ(ux) * uy) + 0.25 * (ux * SQ(uy)) - 0.25 * (ux * uy)) * k0
+	fPop[7 * stride] = (0.25 * (SQ(ux) * SQ(uy)) - 0.25 * (SQ(ux) * uy) + 0.25 * (ux * SQ(uy)) - 0.25 * (ux * uy)) * k0
 				+ (0.5 * (ux * SQ(uy)) - 0.5 * (ux * uy) - 0.25 * uy + 0.25 * SQ(uy)) * k1
 				+ (0.5 * (ux * uy) - 0.25 * ux + 0.5 * (SQ(ux) * uy) - 0.25 * SQ(ux)) * k2
 				+ (0.125 * SQ(ux) + 0.125 * ux + 0.125 * SQ(uy) - 0.125 * uy) * k3
@@ -212,7 +1138,7 @@ inline void GridClass::streamCollide(int i, int j, int id) {
 				+ (0.5 * uy - 0.25) * k6
 				+ (0.5 * ux + 0.25) * k7
 				+ 0.25 * k8;
-	fStar[8] = (0.25 * (SQ(ux) * SQ(uy)) + 0.25 * (SQ(ux) * uy) - 0.25 * (ux * SQ(uy)) - 0.25 * (ux * uy)) * k0
+	fPop[8 * stride] = (0.25 * (SQ(ux) * SQ(uy)) + 0.25 * (SQ(ux) * uy) - 0.25 * (ux * SQ(uy)) - 0.25 * (ux * uy)) * k0
 				+ (0.5 * (ux * uy) - 0.25 * uy + 0.5 * (ux * SQ(uy)) - 0.25 * SQ(uy)) * k1
 				+ (0.5 * (SQ(ux) * uy) - 0.5 * (ux * uy) - 0.25 * ux + 0.25 * SQ(ux)) * k2
 				+ (0.125 * SQ(ux) - 0.125 * ux + 0.125 * SQ(uy) + 0.125 * uy) * k3
@@ -221,276 +1147,712 @@ inline void GridClass::streamCollide(int i, int j, int id) {
 				+ (0.5 * uy + 0.25) * k6
 				+ (0.5 * ux - 0.25) * k7
 				+ 0.25 * k8;
+}
 
-	// Now set to f
-	for (int v = 0; v < nVels; v++) {
-
-		// Calculate newx and newy then collide and stream
-		int recv_id = ((i + c[v * dims + eX] + Nx) % Nx) * Ny + ((j + c[v * dims + eY] + Ny) % Ny);
+// Collide populations given the site values with no force (overwritten with post-collision, stored every stride values)
+template <eCollisionType CollisionType>
+__attribute__((always_inline)) inline void GridClass::collideSiteUnforced(double rho, double ux, double uy, double *fPop, int stride, double omegaSite) const {
 
-		// Update new f
-		f[recv_id * nVels + v] = fStar[v];
+	// Central moments (force terms are cheap so use the full kernel)
+	if (CollisionType == eCentralMoments) {
+		collideSite<CollisionType>(rho, ux, uy, 0.0, 0.0, fPop, stride, omegaSite);
+		return;
 	}
-#else
+
+	// Get local relaxation frequency
+	omegaSite = localOmega(rho, ux, uy, fPop, stride, omegaSite);
 
 	// BGK
-	for (int v = 0; v < nVels; v++) {
+	for (int v = 0; v < nVels; v++)
+		fPop[v * stride] = fPop[v * stride] + omegaSite * (equilibrium<CollisionType>(rho, ux, uy, v) - fPop[v * stride]);
+}
 
-		// Calculate newx and newy then collide and stream
-		int recv_id = ((i + c[v * dims + eX] + Nx) % Nx) * Ny + ((j + c[v * dims + eY] + Ny) % Ny);
+// Get local relaxation frequency from the populations (only lowered by the eddy viscosity if LES is on)
+__attribute__((always_inline)) inline double GridClass::localOmega(double rho, double ux, double uy, const double *fPop, int stride, double omegaSite) const {
 
-		// Update new f
-		f[recv_id * nVels + v] = f_n[id * nVels + v] + omega * (equilibrium(id, v) - f_n[id * nVels + v]) + (1.0 - 0.5 * omega) * latticeForce(id, v);
+	// Molecular value
+	if (smagorinsky <= 0.0)
+		return omegaSite;
+
+	// Get second moments
+	double pxx = 0.0;
+	double pyy = 0.0;
+	double pxy = 0.0;
+	for (int v = 0; v < nVels; v++) {
+		pxx += fPop[v * stride] * c[v * dims + eX] * c[v * dims + eX];
+		pyy += fPop[v * stride] * c[v * dims + eY] * c[v * dims + eY];
+		pxy += fPop[v * stride] * c[v * dims + eX] * c[v * dims + eY];
 	}
-#endif
+
+	// Get eddy relaxation frequency
+	return eddyOmega(rho, ux, uy, pxx, pyy, pxy, omegaSite);
+}
+
+// Get relaxation frequency from the second moments (Smagorinsky eddy viscosity with a filter width of one site)
+inline double GridClass::eddyOmega(double rho, double ux, double uy, double pxx, double pyy, double pxy, double omegaSite) const {
+
+	// Non-equilibrium stress
+	double qxx = pxx - rho * (SQ(c_s) + SQ(ux));
+	double qyy = pyy - rho * (SQ(c_s) + SQ(uy));
+	double qxy = pxy - rho * ux * uy;
+	double qNorm = sqrt(SQ(qxx) + SQ(qyy) + 2.0 * SQ(qxy));
+
+	// Total relaxation time is the molecular value plus the eddy part (solved from the stress in closed form)
+	double tau0 = 1.0 / omegaSite;
+	return 2.0 / (tau0 + sqrt(SQ(tau0) + 18.0 * sqrt(2.0) * SQ(smagorinsky) * qNorm / rho));
+}
+
+// Check if a site has any force (gravity, pressure gradient or IBM)
+inline bool GridClass::isForced(int id) const {
+
+	// Check
+	return (xyForce == true || forceMask[id] != 0);
 }
 
 // Equilibrium function
+template <eCollisionType CollisionType>
 inline double GridClass::equilibrium(int id, int v) {
 
+	// Get equilibrium for start of timestep values
+	return equilibrium<CollisionType>(rhoStart(id), uStart(id, eX), uStart(id, eY), v);
+}
+
+// Equilibrium function (given site values)
+template <eCollisionType CollisionType>
+inline double GridClass::equilibrium(double rho, double ux, double uy, int v) const {
+
 	// Extract required quantities
 	int cx = c[v * dims + eX];
 	int cy = c[v * dims + eY];
-	double ux = u_n[id * dims + eX];
-	double uy = u_n[id * dims + eY];
 
-#ifdef CENTRAL_MOMENTS
 	// Central moments (4th order Hermite)
-	return 0.25 * rho_n[id] * w[v] * (9.0 * SQ(cx) * SQ(ux) + 6.0 * cx * ux - 3.0 * SQ(ux) + 2.0) * (9.0 * SQ(cy) * SQ(uy) + 6.0 * cy * uy - 3.0 * SQ(uy) + 2.0);
-#else
+	if (CollisionType == eCentralMoments)
+		return 0.25 * rho * w[v] * (9.0 * SQ(cx) * SQ(ux) + 6.0 * cx * ux - 3.0 * SQ(ux) + 2.0) * (9.0 * SQ(cy) * SQ(uy) + 6.0 * cy * uy - 3.0 * SQ(uy) + 2.0);
+
 	// BGK (2nd order Hermite)
-	return rho_n[id] * w[v] * (1.0 + 3.0 * (cx * ux + cy * uy) + 4.5 * (SQ(ux) * (SQ(cx) - 1.0 / 3.0) + SQ(uy) * (SQ(cy) - 1.0  / 3.0)) + 9.0 * cx * cy * ux * uy);
-#endif
+	return rho * w[v] * (1.0 + 3.0 * (cx * ux + cy * uy) + 4.5 * (SQ(ux) * (SQ(cx) - 1.0 / 3.0) + SQ(uy) * (SQ(cy) - 1.0  / 3.0)) + 9.0 * cx * cy * ux * uy);
 }
 
 // Discretise cartesian force onto lattice (BGK only)
-inline double GridClass::latticeForce(int id, int v) {
+inline double GridClass::latticeForce(double ux, double uy, double Fx, double Fy, int v) const {
 
 	// Extract required quantities
 	int cx = c[v * dims + eX];
 	int cy = c[v * dims + eY];
-	double ux = u_n[id * dims + eX];
-	double uy = u_n[id * dims + eY];
-	double Fx = force_xy[id * dims + eX] + force_ibm[id * dims + eX];
-	double Fy = force_xy[id * dims + eY] + force_ibm[id * dims + eY];
 
 	// Return value
 	return 3.0 * w[v] * (Fx * (cx - ux + cx * 3.0 * (cx * ux + cy * uy)) + (Fy * (cy - uy + cy * 3.0 * (cx * ux + cy * uy))));
 }
 
+// Set forcing for Womersley pressure gradient
+inline void GridClass::womersleyForce(int id, double rhoSite, int tStep) {
+
+	// Calculate forcing
+	force_xy[id * dims + eX] = (rhoSite * Drho * gravityX + dpdx * cos(2.0 * M_PI * tStep * Dt / ((SQ(height_p) * M_PI) / (2.0 * SQ(womersley) * nu_p)))) * SQ(Dx * Dt) / Dm;
+	force_xy[id * dims + eY] = (rhoSite * Drho * gravityY + dpdy * cos(2.0 * M_PI * tStep * Dt / ((SQ(height_p) * M_PI) / (2.0 * SQ(womersley) * nu_p)))) * SQ(Dx * Dt) / Dm;
+}
+
+// Set uniform forcing for Womersley pressure gradient (lean memory, so there is no gravity)
+void GridClass::womersleyForce(int tStep) {
+
+	// Calculate forcing
+	bodyForce[eX] = (dpdx * cos(2.0 * M_PI * tStep * Dt / ((SQ(height_p) * M_PI) / (2.0 * SQ(womersley) * nu_p)))) * SQ(Dx * Dt) / Dm;
+	bodyForce[eY] = (dpdy * cos(2.0 * M_PI * tStep * Dt / ((SQ(height_p) * M_PI) / (2.0 * SQ(womersley) * nu_p)))) * SQ(Dx * Dt) / Dm;
+}
+
 // Compute macroscopic quantities
 inline void GridClass::macroscopic(int id) {
 
+	// Read in populations
+	array<double, nVels> fPop;
+	for (int v = 0; v < nVels; v++)
+		fPop[v] = getPop(f, fIdx(id, v), v);
+
+	// Compute
+	macroscopic(id, fPop);
+}
+
+// Compute macroscopic quantities from given populations
+inline void GridClass::macroscopic(int id, const array<double, nVels> &fPop) {
+
 	// Reset
-	rho[id] = 0.0;
-	u[id * dims + eX] = 0.0;
-	u[id * dims + eY] = 0.0;
+	double rhoSum = 0.0, uxSum = 0.0, uySum = 0.0;
 
 	// Sum to find rho and momentum
 	for (int v = 0; v < nVels; v++) {
-		rho[id] += f[id * nVels + v];
-		u[id * dims + eX] += c[v * dims + eX] * f[id * nVels + v];
-		u[id * dims + eY] += c[v * dims + eY] * f[id * nVels + v];
+		rhoSum += fPop[v];
+		uxSum += c[v * dims + eX] * fPop[v];
+		uySum += c[v * dims + eY] * fPop[v];
 	}
 
 	// Divide by rho to get velocity
-	u[id * dims + eX] = (u[id * dims + eX] + 0.5 * force_xy[id * dims + eX]) / rho[id];
-	u[id * dims + eY] = (u[id * dims + eY] + 0.5 * force_xy[id * dims + eY]) / rho[id];
+	rho[id] = rhoSum;
+	u[id * dims + eX] = (uxSum + 0.5 * siteForce(id, eX)) / rhoSum;
+	u[id * dims + eY] = (uySum + 0.5 * siteForce(id, eY)) / rhoSum;
 }
 
-// Apply boundary conditions
-void GridClass::applyBCs(int i, int j, int id) {
+// Apply BCs and update macroscopic on all BC sites (run by every thread of a team)
+template <eCollisionType CollisionType>
+void GridClass::boundaryKernel() {
 
 	// Get ramp coefficient
-	double rampCoefficient = getRampCoefficient();
+	double rampCoefficient = getRampCoefficient(t);
+
+	// Loop through groups of BC sites with the same type and normal
+	for (size_t g = 0; g + 1 < BCGroup.size(); g++) {
+
+		// Call kernel for this boundary type
+		switch (type[BCVec[BCGroup[g]]]) {
+
+			// Wall BC
+			case eWall:
+				boundaryGroup<CollisionType, eWall>(BCGroup[g], BCGroup[g + 1], rampCoefficient);
+				break;
+
+			// Velocity BC
+			case eVelocity:
+				boundaryGroup<CollisionType, eVelocity>(BCGroup[g], BCGroup[g + 1], rampCoefficient);
+				break;
+
+			// Free slip BC
+			case eFreeSlip:
+				boundaryGroup<CollisionType, eFreeSlip>(BCGroup[g], BCGroup[g + 1], rampCoefficient);
+				break;
+
+			// Uniform pressure BC
+			case ePressure:
+				boundaryGroup<CollisionType, ePressure>(BCGroup[g], BCGroup[g + 1], rampCoefficient);
+				break;
+
+			// Convective BC
+			case eConvective:
+				boundaryGroup<CollisionType, eConvective>(BCGroup[g], BCGroup[g + 1], rampCoefficient);
+				break;
+
+			// Fluid or solid (don't do anything)
+			case eFluid:
+			case eSolid:
+				break;
+		}
+	}
 
-	// Get normal direction
-	eDirectionType normalDirection;
-	array<int, dims> normalVector = getNormalVector(i, j, normalDirection);
+	// Wait for all groups to finish
+#pragma omp barrier
+}
 
-	// Boundary type
-	switch (type[id]) {
+// Apply BCs and update macroscopic on a group of BC sites with the same type and normal
+template <eCollisionType CollisionType, eLatType BCType>
+void GridClass::boundaryGroup(int start, int end, double rampCoefficient) {
 
-		// Wall BC
-		case eWall:
+	// Loop through sites in group (threads go straight on to the next group)
+#pragma omp for schedule(static) nowait
+	for (int bc = start; bc < end; bc++) {
 
-			// Set velocity to zero
-			u_n[id * dims + eX] = 0.0;
-			u_n[id * dims + eY] = 0.0;
+		// ID
+		int id = BCVec[bc];
 
-			// Do regularised BC
-			regularisedBC(i, j, id, normalVector, normalDirection);
-			break;
+		// Apply boundary condition and update macroscopic
+		applyBC<CollisionType, BCType>(bc, rampCoefficient);
+		macroscopic(id);
 
+		// Store moments of the BC populations
+#ifdef MOMENTS
+		array<double, nVels> fPop;
+		getPostStream(BCDesc[bc].i, BCDesc[bc].j, id, fPop);
+		setMoments(id, fPop);
+#endif
+	}
+}
 
-		// Velocity BC
-		case eVelocity:
+// Apply boundary condition at a BC site
+template <eCollisionType CollisionType>
+void GridClass::applyBCs(int bc, double rampCoefficient) {
 
-			// Set velocity to boundary values
-			u_n[id * dims + eX] = u_in[j * dims + eX] * rampCoefficient;
-			u_n[id * dims + eY] = u_in[j * dims + eY] * rampCoefficient;
+	// Boundary type
+	switch (type[BCVec[bc]]) {
 
-			// Do regularised BC
-			regularisedBC(i, j, id, normalVector, normalDirection);
+		// Wall BC
+		case eWall:
+			applyBC<CollisionType, eWall>(bc, rampCoefficient);
 			break;
 
+		// Velocity BC
+		case eVelocity:
+			applyBC<CollisionType, eVelocity>(bc, rampCoefficient);
+			break;
 
 		// Free slip BC
 		case eFreeSlip:
+			applyBC<CollisionType, eFreeSlip>(bc, rampCoefficient);
+			break;
 
-			// Normal velocity is zero
-			u_n[id * dims + normalDirection] = 0.0;
+		// Uniform pressure BC
+		case ePressure:
+			applyBC<CollisionType, ePressure>(bc, rampCoefficient);
+			break;
 
-			// Extrapolate tangential velocities
-			for (int d = 0; d < dims; d++) {
-				if (d != normalDirection)
-					u_n[id * dims + d] = Utils::zeroGradient(u, normalVector, 2, i, j, d, dims);
-			}
+		// Convective BC
+		case eConvective:
+			applyBC<CollisionType, eConvective>(bc, rampCoefficient);
+			break;
 
-			// Do regularised BC
-			regularisedBC(i, j, id, normalVector, normalDirection);
+		// Fluid or solid (don't do anything)
+		case eFluid:
+		case eSolid:
 			break;
+	}
+}
 
+// Apply boundary condition of given type at a BC site
+template <eCollisionType CollisionType, eLatType BCType>
+inline void GridClass::applyBC(int bc, double rampCoefficient) {
 
-		// Uniform pressure BC
-		case ePressure:
+	// Get descriptor and ID
+	const BCDescriptor &desc = BCDesc[bc];
+	int id = BCVec[bc];
 
-			// Set density to boundary values
-			rho_n[id] = rho_in[j];
+	// Wall BC
+	if (BCType == eWall) {
 
-			// Extrapolate tangential velocities
-			for (int d = 0; d < dims; d++) {
-				if (d != normalDirection)
-					u_n[id * dims + d] = Utils::zeroGradient(u, normalVector, 2, i, j, d, dims);
-			}
+		// Set velocity to zero
+		uBCSite(bc, eX) = 0.0;
+		uBCSite(bc, eY) = 0.0;
+	}
 
-			// Do regularised BC
-			regularisedBC(i, j, id, normalVector, normalDirection);
-			break;
+	// Velocity BC
+	else if (BCType == eVelocity) {
 
+		// Set velocity to boundary values
+		uBCSite(bc, eX) = u_in[desc.j * dims + eX] * rampCoefficient;
+		uBCSite(bc, eY) = u_in[desc.j * dims + eY] * rampCoefficient;
+	}
 
-		// Convective BC
-		case eConvective:
+	// Free slip BC
+	else if (BCType == eFreeSlip) {
 
-			// Do regularised BC
-			convectiveBC(j, id);
-			break;
+		// Normal velocity is zero
+		uBCSite(bc, desc.normalDirection) = 0.0;
 
+		// Extrapolate tangential velocities
+		for (int d = 0; d < dims; d++) {
+			if (d != desc.normalDirection)
+				uBCSite(bc, d) = Utils::zeroGradient(u, desc.inward, 2, d, dims);
+		}
+	}
 
-		// Fluid (don't do anything)
-		case eFluid:
-			break;
+	// Uniform pressure BC
+	else if (BCType == ePressure) {
+
+		// Set density to boundary values
+		rhoBCSite(bc) = rho_in[desc.j];
+
+		// Extrapolate tangential velocities
+		for (int d = 0; d < dims; d++) {
+			if (d != desc.normalDirection)
+				uBCSite(bc, d) = Utils::zeroGradient(u, desc.inward, 2, d, dims);
+		}
 	}
+
+	// Convective BC (not regularised)
+	else if (BCType == eConvective) {
+		convectiveBC(desc.j, id);
+		return;
+	}
+
+	// Do regularised BC
+	regularisedBC<CollisionType, BCType>(bc);
 }
 
 // Regularised BC
-void GridClass::regularisedBC(int i, int j, int id, array<int, dims> &normalVector, eDirectionType normalDirection) {
+template <eCollisionType CollisionType, eLatType BCType>
+inline void GridClass::regularisedBC(int bc) {
+
+	// Get descriptor and ID
+	const BCDescriptor &desc = BCDesc[bc];
+	int id = BCVec[bc];
+	int nd = desc.normalDirection;
+
+	// Read populations
+	array<double, nVels> fPop;
+	for (int v = 0; v < nVels; v++)
+		fPop[v] = getPop(f, fIdx(id, v), v);
+
+	// If it is a corner then we need to extrapolate
+	if (desc.corner == true) {
+
+		// If velocity BC then extrapolate density
+		if (BCType != ePressure)
+			rhoBCSite(bc) = Utils::extrapolate(rho, desc.inward, 1);
+	}
+
+	// Otherwise normal edge
+	else {
+
+		// Declare fplus and fzero
+		double fplus = 0.0, fzero = 0.0;
+
+		// Loop through velocities
+		for (int v = 0; v < nVels; v++) {
+
+			// If opposite link is unknown then add to fplus
+			if (desc.unknownMask & (1 << opposite[v]))
+				fplus += fPop[v];
+
+			// If it is perpendicular to wall then add to fzero
+			else if (!(desc.unknownMask & (1 << v)))
+				fzero += fPop[v];
+		}
+
+		// Velocity condition
+		if (BCType != ePressure)
+			rhoBCSite(bc) = (2.0 * fplus + fzero) / (1.0 - desc.normal[nd] * uBCSite(bc, nd));
+
+		// Pressure condition
+		else
+			uBCSite(bc, nd) = desc.normal[nd] * (1.0 - (2.0 * fplus + fzero) / rhoBCSite(bc));
+	}
+
+	// Get equilibrium
+	array<double, nVels> feq;
+	for (int v = 0; v < nVels; v++)
+		feq[v] = equilibrium<CollisionType>(rhoBCSite(bc), uBCSite(bc, eX), uBCSite(bc, eY), v);
+
+	// Declare stresses
+	double Sxx = 0.0, Syy = 0.0, Sxy = 0.0;
+
+	// Set unknowns and get stresses
+	for (int v = 0; v < nVels; v++) {
+
+		// If buried link just set to feq, otherwise bounce back off-equilibrium
+		if (desc.buriedMask & (1 << v))
+			fPop[v] = feq[v];
+		else if (desc.unknownMask & (1 << v))
+			fPop[v] = feq[v] + (fPop[opposite[v]] - feq[opposite[v]]);
+
+		// Store off-equilibrium
+		double fneq = fPop[v] - feq[v];
+
+		// Compute off-equilbrium stress components
+		Sxx += c[v * dims + eX] * c[v * dims + eX] * fneq;
+		Syy += c[v * dims + eY] * c[v * dims + eY] * fneq;
+		Sxy += c[v * dims + eX] * c[v * dims + eY] * fneq;
+	}
+
+	// Compute regularised non-equilibrium components and add to feq to get new populations
+	for (int v = 0; v < nVels; v++)
+		setPop(f, fIdx(id, v), v, feq[v] + (w[v] / (2.0 * QU(c_s))) * (((SQ(c[v * dims + eX]) - SQ(c_s)) * Sxx) + ((SQ(c[v * dims + eY]) - SQ(c_s)) * Syy) + (2.0 * c[v * dims + eX] * c[v * dims + eY] * Sxy)));
+}
+
+// Convective BC
+void GridClass::convectiveBC(int j, int id) {
+
+	// Get start of timestep populations
+#if defined AA_PATTERN || defined FUSED || defined MOMENTS
+	const double *fPrev = &f_out[j * nVels];
+#else
+	array<double, nVels> fPrev;
+	for (int v = 0; v < nVels; v++)
+		fPrev[v] = getPop(f_n, fIdx(id, v), v);
+#endif
+
+	// Set the values
+	setPop(f, fIdx(id, 2), 2, fPrev[2] + 3.0 * w[2] * (delU[j * dims + eX] * c[2 * dims + eX] + delU[j * dims + eY] * c[2 * dims + eY]));
+	setPop(f, fIdx(id, 6), 6, fPrev[6] + 3.0 * w[6] * (delU[j * dims + eX] * c[6 * dims + eX] + delU[j * dims + eY] * c[6 * dims + eY]));
+	setPop(f, fIdx(id, 8), 8, fPrev[8] + 3.0 * w[8] * (delU[j * dims + eX] * c[8 * dims + eX] + delU[j * dims + eY] * c[8 * dims + eY]));
+}
+
+// Calculate convective speed
+void GridClass::convectiveSpeed() {
+
+	// Set uOut to zero (every thread gets its own copy of the sum)
+	double uOut = 0.0;
+
+	// Loop through outlet
+	for (int j = 0; j < Ny; j++)
+		uOut += u[siteIdx(Nx - 1, j) * dims + eX];
+
+	// Get average
+	uOut /= static_cast<double>(Ny);
+
+	// Now loop through again and get delU
+#pragma omp for schedule(static)
+	for (int j = 0; j < Ny; j++) {
+		delU[j * dims + eX] = (-uOut / 2.0) * (3.0 * u[siteIdx(Nx - 1, j) * dims + eX] - 4.0 * u[siteIdx(Nx - 2, j) * dims + eX] + u[siteIdx(Nx - 3, j) * dims + eX]);
+		delU[j * dims + eY] = (-uOut / 2.0) * (3.0 * u[siteIdx(Nx - 1, j) * dims + eY] - 4.0 * u[siteIdx(Nx - 2, j) * dims + eY] + u[siteIdx(Nx - 3, j) * dims + eY]);
+	}
+}
+
+// Send populations streamed into the ghost columns to the neighbouring ranks
+void GridClass::exchangePops() {
+
+#ifdef MPI_SLABS
+
+	// Neighbouring ranks (periodic)
+	int left = (rank - 1 + nRanks) % nRanks;
+	int right = (rank + 1) % nRanks;
+
+	// Links leaving the slab to the left (c_x = -1) then to the right (c_x = 1)
+	for (int cx = -1; cx <= 1; cx += 2) {
+
+		// Ghost column the links were pushed into (edge column of the next rank) and the edge column of this rank which receives the same links
+		int idGhost = (cx < 0 ? 0 : idEnd);
+		int idEdge = (cx < 0 ? idEnd - Ny : idStart);
+
+		// Pack the populations
+		vector<popType> sendBuf;
+		for (int j = 0; j < Ny; j++) {
+			for (int v = 0; v < nVels; v++) {
+				if (c[v * dims + eX] == cx)
+					sendBuf.push_back(f[popIdx(idGhost + j, v)]);
+			}
+		}
+
+		// Send to the next rank and receive from the one before
+		vector<popType> recvBuf(sendBuf.size());
+		int bytes = static_cast<int>(sendBuf.size() * sizeof(popType));
+		MPI_Sendrecv(sendBuf.data(), bytes, MPI_BYTE, (cx < 0 ? left : right), cx + 1,
+				recvBuf.data(), bytes, MPI_BYTE, (cx < 0 ? right : left), cx + 1, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+
+		// Unpack into the edge column
+		int n = 0;
+		for (int j = 0; j < Ny; j++) {
+			for (int v = 0; v < nVels; v++) {
+				if (c[v * dims + eX] == cx)
+					f[popIdx(idEdge + j, v)] = recvBuf[n++];
+			}
+		}
+	}
+#endif
+}
+
+// Send density and velocity of the edge columns to the neighbouring ranks
+void GridClass::exchangeMacroscopic() {
+
+#ifdef MPI_SLABS
+
+	// Neighbouring ranks (periodic)
+	int left = (rank - 1 + nRanks) % nRanks;
+	int right = (rank + 1) % nRanks;
+
+	// Ghost columns are the first and last local columns
+	int idLeft = 0;
+	int idRight = idEnd;
+
+	// Send first column to the left and get the right ghost column
+	MPI_Sendrecv(&rho[idStart], Ny, MPI_DOUBLE, left, 0, &rho[idRight], Ny, MPI_DOUBLE, right, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+	MPI_Sendrecv(&u[idStart * dims], Ny * dims, MPI_DOUBLE, left, 1, &u[idRight * dims], Ny * dims, MPI_DOUBLE, right, 1, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+
+	// Send last column to the right and get the left ghost column
+	MPI_Sendrecv(&rho[idEnd - Ny], Ny, MPI_DOUBLE, right, 2, &rho[idLeft], Ny, MPI_DOUBLE, left, 2, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+	MPI_Sendrecv(&u[(idEnd - Ny) * dims], Ny * dims, MPI_DOUBLE, right, 3, &u[idLeft * dims], Ny * dims, MPI_DOUBLE, left, 3, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+#endif
+}
+
+// Advance a refined patch over one step of its parent (two sub-steps then feed back to the parent, run by every thread of a team)
+template <eCollisionType CollisionType>
+void GridClass::patchKernel(int level, bool last) {
+
+	// Get patch
+	GridPatch &p = patch[level - 1];
+
+	// Get parent populations on the ring at the end of the parent step
+#pragma omp for schedule(static)
+	for (size_t r = 0; r < p.ringSites.size(); r++)
+		getLevelPops(level - 1, p.ringSites[r], &p.fRing[r * nVels]);
+
+	// Loop through the two sub-steps
+	for (int sub = 0; sub < 2; sub++) {
+
+		// Swap to start of sub-step (only one thread)
+#pragma omp single
+		{
+			p.f_n.swap(p.f);
+			p.u_n.swap(p.u);
+			p.rho_n.swap(p.rho);
+		}
+
+		// Loop through all patch sites
+#pragma omp for schedule(static) collapse(2)
+		for (int fi = 0; fi < p.nx; fi++) {
+			for (int fj = 0; fj < p.ny; fj++) {
+
+				// Stream and collide in one go
+				patchStreamCollide<CollisionType>(p, fi, fj);
+			}
+		}
+
+		// Rebuild the edge sites from the parent (half way through the parent step then at the end)
+#pragma omp for schedule(static)
+		for (size_t e = 0; e < p.edgeSites.size(); e++)
+			patchEdge<CollisionType>(p, static_cast<int>(e), 0.5 * (sub + 1));
+
+		// Leave out the IBM force after the last sub-step of the time step (so the markers interpolate the unforced velocity)
+		bool withIBM = !(last == true && sub == 1);
+
+		// Update macroscopic values
+#pragma omp for schedule(static)
+		for (int id = 0; id < p.nx * p.ny; id++)
+			patchMacroscopic(p, id, withIBM);
 
-	// If it is a corner then we need to extrapolate
-	if (normalVector[eX] != 0 && normalVector[eY] != 0) {
+		// Advance the next level over this sub-step
+		if (level < static_cast<int>(patch.size()))
+			patchKernel<CollisionType>(level + 1, !withIBM);
+	}
 
-		// If velocity BC then extrapolate density
-		if (type[id] == eVelocity || type[id] == eWall || type[id] == eFreeSlip)
-			rho_n[id] = Utils::extrapolate(rho, normalVector, 1, i, j);
+	// Set the parent sites inside the patch (not the ring) from the patch
+#pragma omp for schedule(static) collapse(2)
+	for (int pi = p.i0 + 1; pi < p.i0 + (p.nx - 1) / 2; pi++) {
+		for (int pj = p.j0 + 1; pj < p.j0 + (p.ny - 1) / 2; pj++)
+			restrictSite<CollisionType>(p, pi, pj, !last);
 	}
 
-	// Otherwise normal edge
-	else {
+	// Keep the ring for the start of the next parent step (only one thread)
+#pragma omp single
+	p.fRing_n.swap(p.fRing);
+}
 
-		// Declare fplus and fzero
-		double fplus = 0.0, fzero = 0.0;
+// Stream and collide at a patch site (populations leaving the patch are dropped)
+template <eCollisionType CollisionType>
+inline void GridClass::patchStreamCollide(GridPatch &p, int fi, int fj) {
 
-		// Loop through velocities
-		for (int v = 0; v < nVels; v++) {
+	// ID
+	int id = fi * p.ny + fj;
 
-			// If normal is opposite then add to fplus
-			if (c[v * dims + normalDirection] == -normalVector[normalDirection])
-				fplus += f[id * nVels + v];
+	// Read in start of sub-step populations
+	array<double, nVels> fPop;
+	for (int v = 0; v < nVels; v++)
+		fPop[v] = p.f_n[id * nVels + v];
 
-			// If it is perpendicular to wall then add to fzero
-			else if (c[v * dims + normalDirection] == 0)
-				fzero += f[id * nVels + v];
-		}
+	// Collide at the patch rate (only read forces if the site has one)
+	if (xyForce == true || p.forceMask[id] != 0) {
+		double Fx = p.forceXY[eX] + p.force_ibm[id * dims + eX];
+		double Fy = p.forceXY[eY] + p.force_ibm[id * dims + eY];
+		collideSite<CollisionType>(p.rho_n[id], p.u_n[id * dims + eX], p.u_n[id * dims + eY], Fx, Fy, fPop.data(), 1, p.omega);
+	}
+	else {
+		collideSiteUnforced<CollisionType>(p.rho_n[id], p.u_n[id * dims + eX], p.u_n[id * dims + eY], fPop.data(), 1, p.omega);
+	}
 
-		// Velocity condition
-		if (type[id] == eVelocity || type[id] == eWall || type[id] == eFreeSlip) {
-			rho_n[id] = (2.0 * fplus + fzero) / (1.0 - normalVector[normalDirection] * u_n[id * dims + normalDirection]);
-		}
+	// Push to neighbours inside the patch
+	for (int v = 0; v < nVels; v++) {
+		int fiRecv = fi + c[v * dims + eX];
+		int fjRecv = fj + c[v * dims + eY];
+		if (fiRecv >= 0 && fiRecv < p.nx && fjRecv >= 0 && fjRecv < p.ny)
+			p.f[(fiRecv * p.ny + fjRecv) * nVels + v] = fPop[v];
+	}
+}
 
-		// Pressure condition
-		else if (type[id] == ePressure) {
-			u_n[id * dims + normalDirection] = normalVector[normalDirection] * (1.0 - (2.0 * fplus + fzero) / rho_n[id]);
+// Rebuild a patch edge site from the parent ring (cubic in space, linear in time, frac of the way through the parent step)
+template <eCollisionType CollisionType>
+inline void GridClass::patchEdge(GridPatch &p, int e, double frac) {
+
+	// Interpolate the parent populations
+	array<double, nVels> fPar = {0.0};
+	for (int k = 0; k < 4; k++) {
+		if (p.edgeWeight[e][k] != 0.0) {
+			int r = p.edgeFrom[e][k];
+			for (int v = 0; v < nVels; v++)
+				fPar[v] += p.edgeWeight[e][k] * ((1.0 - frac) * p.fRing_n[r * nVels + v] + frac * p.fRing[r * nVels + v]);
 		}
 	}
 
-	// Declare stresses
-	double Sxx = 0.0, Syy = 0.0, Sxy = 0.0;
-
-	// Update f values
-	for (int v = 0; v < nVels; v++) {
+	// Rescale to the patch (non-equilibrium part scales with tau / 2 tau_parent)
+	rescalePops<CollisionType>(fPar.data(), levelForceXY(p.level - 1), p.forceXY, levelOmega(p.level - 1) / (2.0 * p.omega), &p.f[p.edgeSites[e] * nVels]);
+}
 
-		// Get feq
-		double feq = equilibrium(id, v);
+// Set a parent site inside the patch from the coincident patch site
+template <eCollisionType CollisionType>
+inline void GridClass::restrictSite(GridPatch &p, int pi, int pj, bool withIBM) {
 
-		// If corner then unknowns share at least one of normal components
-		if (normalVector[eX] != 0 && normalVector[eY] != 0) {
-			if (c[v * dims + eX] == normalVector[eX] || c[v * dims + eY] == normalVector[eY]) {
+	// IDs of the patch site and the parent site
+	int id = (2 * (pi - p.i0)) * p.ny + 2 * (pj - p.j0);
+	int pid = levelSiteIdx(p.level - 1, pi, pj);
 
-				// If buried link just set to feq
-				if (normalVector[eX] * c[v * dims + eX] + normalVector[eY] * c[v * dims + eY] == 0)
-					f[id * nVels + v] = feq;
-				else
-					f[id * nVels + v] = feq + (f[id * nVels + opposite[v]] - equilibrium(id, opposite[v]));
-			}
-		}
+	// Rescale to the parent (non-equilibrium part scales with 2 tau_parent / tau)
+	array<double, nVels> fPop;
+	rescalePops<CollisionType>(&p.f[id * nVels], p.forceXY, levelForceXY(p.level - 1), 2.0 * p.omega / levelOmega(p.level - 1), fPop.data());
+	setLevelPops(p.level - 1, pid, fPop.data());
 
-		// If other then unknowns share the normal vector component
-		else {
-			if (c[v * dims + normalDirection] == normalVector[normalDirection])
-				f[id * nVels + v] = feq + (f[id * nVels + opposite[v]] - equilibrium(id, opposite[v]));
-		}
+	// Update parent macroscopic values
+	if (p.level == 1)
+		macroscopic(pid);
+	else
+		patchMacroscopic(patch[p.level - 2], pid, withIBM);
+}
 
-		// Store off-equilibrium
-		double fneq = f[id * nVels + v] - feq;
+// Move populations between levels (equilibrium is kept at the same physical velocity and the non-equilibrium part is multiplied by ratio)
+template <eCollisionType CollisionType>
+inline void GridClass::rescalePops(const double *fIn, const array<double, dims> &FIn, const array<double, dims> &FOut, double ratio, double *fOut) const {
 
-		// Compute off-equilbrium stress components
-		Sxx += c[v * dims + eX] * c[v * dims + eX] * fneq;
-		Syy += c[v * dims + eY] * c[v * dims + eY] * fneq;
-		Sxy += c[v * dims + eX] * c[v * dims + eY] * fneq;
+	// Sum to find rho and momentum
+	double rhoSum = 0.0, uxSum = 0.0, uySum = 0.0;
+	for (int v = 0; v < nVels; v++) {
+		rhoSum += fIn[v];
+		uxSum += c[v * dims + eX] * fIn[v];
+		uySum += c[v * dims + eY] * fIn[v];
 	}
 
-	// Compute regularised non-equilibrium components and add to feq to get new populations
+	// Velocity of the populations and velocity which gives the same forced velocity with the new force
+	double uxIn = uxSum / rhoSum;
+	double uyIn = uySum / rhoSum;
+	double uxOut = (uxSum + 0.5 * (FIn[eX] - FOut[eX])) / rhoSum;
+	double uyOut = (uySum + 0.5 * (FIn[eY] - FOut[eY])) / rhoSum;
+
+	// Rebuild populations
 	for (int v = 0; v < nVels; v++)
-		f[id * nVels + v] = equilibrium(id, v) + (w[v] / (2.0 * QU(c_s))) * (((SQ(c[v * dims + eX]) - SQ(c_s)) * Sxx) + ((SQ(c[v * dims + eY]) - SQ(c_s)) * Syy) + (2.0 * c[v * dims + eX] * c[v * dims + eY] * Sxy));
+		fOut[v] = equilibrium<CollisionType>(rhoSum, uxOut, uyOut, v) + ratio * (fIn[v] - equilibrium<CollisionType>(rhoSum, uxIn, uyIn, v));
 }
 
-// Convective BC
-void GridClass::convectiveBC(int j, int id) {
+// Compute macroscopic quantities at a patch site
+inline void GridClass::patchMacroscopic(GridPatch &p, int id, bool withIBM) {
 
-	// Set the values
-	f[id * nVels + 2] = f_n[id * nVels + 2] + 3.0 * w[2] * (delU[j * dims + eX] * c[2 * dims + eX] + delU[j * dims + eY] * c[2 * dims + eY]);
-	f[id * nVels + 6] = f_n[id * nVels + 6] + 3.0 * w[6] * (delU[j * dims + eX] * c[6 * dims + eX] + delU[j * dims + eY] * c[6 * dims + eY]);
-	f[id * nVels + 8] = f_n[id * nVels + 8] + 3.0 * w[8] * (delU[j * dims + eX] * c[8 * dims + eX] + delU[j * dims + eY] * c[8 * dims + eY]);
+	// Sum to find rho and momentum
+	double rhoSum = 0.0, uxSum = 0.0, uySum = 0.0;
+	for (int v = 0; v < nVels; v++) {
+		rhoSum += p.f[id * nVels + v];
+		uxSum += c[v * dims + eX] * p.f[id * nVels + v];
+		uySum += c[v * dims + eY] * p.f[id * nVels + v];
+	}
+
+	// Get force on site
+	double Fx = p.forceXY[eX] + (withIBM == true ? p.force_ibm[id * dims + eX] : 0.0);
+	double Fy = p.forceXY[eY] + (withIBM == true ? p.force_ibm[id * dims + eY] : 0.0);
+
+	// Divide by rho to get velocity
+	p.rho[id] = rhoSum;
+	p.u[id * dims + eX] = (uxSum + 0.5 * Fx) / rhoSum;
+	p.u[id * dims + eY] = (uySum + 0.5 * Fy) / rhoSum;
 }
 
-// Calculate convective speed
-void GridClass::convectiveSpeed() {
+// Read populations at a site of a level (grid or refined patch)
+inline void GridClass::getLevelPops(int level, int id, double *fPop) {
 
-	// Set uOut to zero
-	double uOut = 0.0;
+	// Grid
+	if (level == 0) {
+		for (int v = 0; v < nVels; v++)
+			fPop[v] = getPop(f, fIdx(id, v), v);
+	}
 
-	// Loop through outlet
-	for (int j = 0; j < Ny; j++)
-		uOut += u[((Nx - 1) * Ny + j) * dims + eX];
+	// Refined patch
+	else {
+		for (int v = 0; v < nVels; v++)
+			fPop[v] = patch[level - 1].f[id * nVels + v];
+	}
+}
 
-	// Get average
-	uOut /= static_cast<double>(Ny);
+// Store populations at a site of a level (grid or refined patch)
+inline void GridClass::setLevelPops(int level, int id, const double *fPop) {
 
-	// Now loop through again and get delU
-#pragma omp parallel for schedule(guided)
-	for (int j = 0; j < Ny; j++) {
-		delU[j * dims + eX] = (-uOut / 2.0) * (3.0 * u[((Nx - 1) * Ny + j) * dims + eX] - 4.0 * u[((Nx - 2) * Ny + j) * dims + eX] + u[((Nx - 3) * Ny + j) * dims + eX]);
-		delU[j * dims + eY] = (-uOut / 2.0) * (3.0 * u[((Nx - 1) * Ny + j) * dims + eY] - 4.0 * u[((Nx - 2) * Ny + j) * dims + eY] + u[((Nx - 3) * Ny + j) * dims + eY]);
+	// Grid
+	if (level == 0) {
+		for (int v = 0; v < nVels; v++)
+			setPop(f, fIdx(id, v), v, fPop[v]);
+	}
+
+	// Refined patch
+	else {
+		for (int v = 0; v < nVels; v++)
+			patch[level - 1].f[id * nVels + v] = fPop[v];
 	}
 }
 
@@ -524,17 +1886,17 @@ inline array<int, dims> GridClass::getNormalVector(int i, int j, eDirectionType
 	if (normalVector[eX] != 0 && normalVector[eY] != 0) {
 
 		// If surrounded by periodic cells then something has gone wrong
-		if (type[(i + normalVector[eX]) * Ny + j] == eFluid && type[i * Ny + j + normalVector[eY]] == eFluid)
+		if (type[siteIdx(i + normalVector[eX], j)] == eFluid && type[siteIdx(i, j + normalVector[eY])] == eFluid)
 			ERROR("Corner node is surrounded by fluid lattice sites...exiting");
 
 		// Check in x-direction
-		else if (type[(i + normalVector[eX]) * Ny + j] == eFluid) {
+		else if (type[siteIdx(i + normalVector[eX], j)] == eFluid) {
 			normalDirection = eX;
 			normalVector[eY] = 0;
 		}
 
 		// Check in y-direction
-		else if (type[i * Ny + j + normalVector[eY]] == eFluid) {
+		else if (type[siteIdx(i, j + normalVector[eY])] == eFluid) {
 			normalDirection = eY;
 			normalVector[eX] = 0;
 		}
@@ -544,40 +1906,142 @@ inline array<int, dims> GridClass::getNormalVector(int i, int j, eDirectionType
 	return normalVector;
 }
 
-// Get inlet ramp coefficient
-double GridClass::getRampCoefficient() {
+// Get inlet ramp coefficient at a time step
+double GridClass::getRampCoefficient(int tStep) {
 
 	// Get ramp coefficient
-#ifdef INLET_RAMP
-	if (Dt * t <= INLET_RAMP)
-		return (1.0 - cos(M_PI * Dt * t / INLET_RAMP)) / 2.0;
-#endif
+	if (inletRamp > 0.0 && Dt * tStep <= inletRamp)
+		return (1.0 - cos(M_PI * Dt * tStep / inletRamp)) / 2.0;
 	return 1.0;
 }
 
+// Finest level which holds the IBM support of a marker (0 if it is outside every patch)
+int GridClass::markerLevel(const array<double, dims> &pos) const {
+
+	// Loop from the finest level down
+	for (int l = static_cast<int>(patch.size()); l > 0; l--) {
+
+		// Get patch
+		const GridPatch &p = patch[l - 1];
+
+		// Check if marker is inside the patch at all
+		if (pos[eX] < p.origin[eX] || pos[eX] > p.origin[eX] + (p.nx - 1) * p.Dx || pos[eY] < p.origin[eY] || pos[eY] > p.origin[eY] + (p.ny - 1) * p.Dx)
+			continue;
+
+		// Support must not reach the edges of the patch
+		if (inInterior(l, pos) == false)
+			ERROR("IBM marker has moved too close to the edge of refined patch " + to_string(l) + " (increase the REFINE margin)...exiting");
+		return l;
+	}
+
+	// Marker is on the grid
+	return 0;
+}
+
+// Check if the IBM support around a position is inside a patch (away from the edge sites and the sites they stream into)
+bool GridClass::inInterior(int level, const array<double, dims> &pos) const {
+
+	// The grid holds everything
+	if (level == 0)
+		return true;
+
+	// Get nearest site of the patch
+	const GridPatch &p = patch[level - 1];
+	int i = static_cast<int>(round((pos[eX] - p.origin[eX]) / p.Dx));
+	int j = static_cast<int>(round((pos[eY] - p.origin[eY]) / p.Dx));
+
+	// Check
+	return (i >= 3 && i <= p.nx - 4 && j >= 3 && j <= p.ny - 4);
+}
+
+// Finest level which holds a body (given its bounding box)
+int GridClass::bodyLevel(const array<double, dims> &lo, const array<double, dims> &hi) const {
+
+	// Loop from the finest level down
+	for (int l = static_cast<int>(patch.size()); l > 0; l--) {
+		if (inInterior(l, lo) == true && inInterior(l, hi) == true)
+			return l;
+	}
+
+	// Body is on the grid
+	return 0;
+}
+
+// Lattice spacing of a level
+double GridClass::levelDx(int level) const {
+
+	// Return value
+	return (level == 0 ? Dx : patch[level - 1].Dx);
+}
+
+// Position of the first site of a level
+array<double, dims> GridClass::levelOrigin(int level) const {
+
+	// Return value
+	return (level == 0 ? array<double, dims>{0.0, 0.0} : patch[level - 1].origin);
+}
+
+// Number of sites of a level in x-direction
+int GridClass::levelNx(int level) const {
+
+	// Return value
+	return (level == 0 ? Nx : patch[level - 1].nx);
+}
+
+// Number of sites of a level in y-direction
+int GridClass::levelNy(int level) const {
+
+	// Return value
+	return (level == 0 ? Ny : patch[level - 1].ny);
+}
+
+// Site ID of site (i, j) of a level
+int GridClass::levelSiteIdx(int level, int i, int j) const {
+
+	// Return value
+	return (level == 0 ? siteIdx(i, j) : i * patch[level - 1].ny + j);
+}
+
+// Relaxation frequency of a level
+double GridClass::levelOmega(int level) const {
+
+	// Return value
+	return (level == 0 ? omega : patch[level - 1].omega);
+}
+
+// Cartesian force (pressure and gravity) of a level
+array<double, dims> GridClass::levelForceXY(int level) const {
+
+	// Grid (gravity is taken at rho0 as every site starts there, only the Womersley force weights it by the site density and that is not used with refinement)
+	if (level == 0) {
+		array<double, dims> F = {(Drho * gravityX + dpdx) * SQ(Dx * Dt) / Dm, (Drho * gravityY + dpdy) * SQ(Dx * Dt) / Dm};
+		return F;
+	}
+
+	// Refined patch
+	return patch[level - 1].forceXY;
+}
+
 // Write info at tInfo frequency
 void GridClass::writeInfo() {
 
-	// Calculate max velocity
+	// Calculate max velocity (over the columns of this rank) and find the first site that blew up
 	double maxVel = 0.0;
-	for (int i = 0; i < Nx; i++) {
+	long long nSitesGlobal = static_cast<long long>(Nx) * Ny;
+	long long nanID = nSitesGlobal;
+	for (int i = iStart; i < iEnd && nanID == nSitesGlobal; i++) {
 		for (int j = 0; j < Ny; j++) {
 
 			// Get id
-			int id = i * Ny + j;
+			int id = siteIdx(i, j);
 
 			// Get velocity
 			double vel = sqrt(SQ(u[id * dims + eX]) + SQ(u[id * dims + eY]));
 
 			// Check if isnan then break
 			if (std::isnan(vel) == true) {
-
-				// Write VTK data
-#ifdef VTK
-				Utils::writeVTK(*this);
-#endif
-				// Tell user where it blew up
-				ERROR("Simulation blew up (t = " + to_string(t) + ") at i = " + to_string(i) + ", j = " + to_string(j) + "...exiting");
+				nanID = static_cast<long long>(i) * Ny + j;
+				break;
 			}
 
 			// If bigger then set
@@ -587,6 +2051,18 @@ void GridClass::writeInfo() {
 		}
 	}
 
+	// Get values over all ranks
+#ifdef MPI_SLABS
+	MPI_Allreduce(MPI_IN_PLACE, &maxVel, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+	MPI_Allreduce(MPI_IN_PLACE, &nanID, 1, MPI_LONG_LONG, MPI_MIN, MPI_COMM_WORLD);
+#endif
+
+	// If it blew up then write VTK data and tell user where
+	if (nanID < nSitesGlobal) {
+		Utils::writeVTK(*this);
+		ERROR("Simulation blew up (t = " + to_string(t) + ") at i = " + to_string(nanID / Ny) + ", j = " + to_string(nanID % Ny) + "...exiting");
+	}
+
 	// Calculate values
 	double maxRe = (maxVel * Dx / Dt) * ref_L / ref_nu;
 
@@ -607,7 +2083,14 @@ void GridClass::writeInfo() {
 	cout << "Time step " << t << " of " << tOffset + nSteps << endl;
 	cout << setprecision(4) << "Simulation has done " << t * Dt << " of " << (tOffset + nSteps) * Dt << " seconds" << endl;
 	cout << "Time to finish = " << hms[0] << " [h] " << hms[1] << " [m] " << hms[2] << " [s]" << endl;
-	cout << setprecision(4) << "MLUPS = " << Nx * Ny / (1000000.0 * loopTime) << endl;
+#ifdef SPARSE
+	double siteUpdates = static_cast<double>(idEnd - idStart);	// Solid sites are not updated
+#else
+	double siteUpdates = static_cast<double>(Nx) * Ny;
+#endif
+	for (size_t l = 0; l < patch.size(); l++)
+		siteUpdates += static_cast<double>(patch[l].nx) * patch[l].ny * (1 << patch[l].level);
+	cout << setprecision(4) << "MLUPS = " << siteUpdates / (1000000.0 * loopTime) << endl;
 
 	// Write out max velocity information
 	cout << setprecision(5) << "Max Velocity = " << maxVel << endl;
@@ -648,6 +2131,11 @@ void GridClass::writeLog() {
 	// Number of threads
 	output << "\n\nRunning with " << Utils::omp_thread_count() << " threads\n";
 
+	// Thread pinning
+#ifdef PIN_THREADS
+	output << "Threads pinned to cores " << Utils::getThreadCores() << "\n";
+#endif
+
 	// OPTIONS
 	output << "\nOPTIONS:\n";
 
@@ -657,18 +2145,123 @@ void GridClass::writeLog() {
 	else
 		output << "RESTART = OFF\n";
 
+	// Collision operator
+	output << "Collision Operator = " << Utils::getCollisionString(collisionType) << "\n";
+
 	// Inlet ramp
-#ifdef INLET_RAMP
-	output << "Inlet Ramp = " << INLET_RAMP << " s\n";
+	if (inletRamp > 0.0)
+		output << "Inlet Ramp = " << inletRamp << " s\n";
+	else
+		output << "Inlet Ramp = OFF\n";
+
+	// Population layout
+	output << "Population Layout = " << Utils::getLayoutString(LAYOUT) << "\n";
+
+	// Population storage precision
+	output << "Population Precision = " << Utils::getPrecisionString(POP_PRECISION) << "\n";
+
+	// AA pattern streaming
+#ifdef AA_PATTERN
+	output << "AA Pattern Streaming = ON\n";
+#else
+	output << "AA Pattern Streaming = OFF\n";
+#endif
+
+	// Ghost layer
+#ifdef HALO
+	output << "Ghost Layer Streaming = ON\n";
+#else
+	output << "Ghost Layer Streaming = OFF\n";
+#endif
+
+	// SIMD kernels
+#ifdef VECTORISED
+	output << "Vectorised Kernels = ON\n";
+#else
+	output << "Vectorised Kernels = OFF\n";
+#endif
+
+	// Fused kernel
+#ifdef FUSED
+	output << "Fused Pull Kernel = ON\n";
+#else
+	output << "Fused Pull Kernel = OFF\n";
+#endif
+
+	// Moment storage
+#ifdef MOMENTS
+	output << "Moment Storage = ON\n";
+#else
+	output << "Moment Storage = OFF\n";
+#endif
+
+	// Sparse lattice
+#ifdef SPARSE
+	output << "Sparse Lattice = ON (" << idEnd << " of " << Nx * Ny << " sites stored)\n";
+#else
+	output << "Sparse Lattice = OFF\n";
+#endif
+
+	// Huge pages (page size the populations actually got)
+#ifdef HUGE_PAGES
+	output << "Huge Pages = ON (populations on " << Utils::getPageString(f.data()) << ")\n";
+#else
+	output << "Huge Pages = OFF (populations on " << Utils::getPageString(f.data()) << ")\n";
+#endif
+
+	// NUMA interleave
+#ifdef NUMA_INTERLEAVE
+	output << "NUMA Interleave = ON\n";
+#else
+	output << "NUMA Interleave = OFF\n";
+#endif
+
+	// Lean memory
+#ifdef LEAN_MEMORY
+	output << "Lean Memory = ON\n";
+#else
+	output << "Lean Memory = OFF\n";
+#endif
+
+	// Cache blocking
+#ifdef TILED
+	output << "Tiled Sweep = " << TILE_X << " x " << TILE_Y << "\n";
+#else
+	output << "Tiled Sweep = OFF\n";
+#endif
+#ifdef TEMPORAL_STEPS
+	if (temporalBlocking() == true)
+		output << "Temporal Blocking = " << TEMPORAL_STEPS << " steps\n";
+	else
+		output << "Temporal Blocking = OFF (needs no IBM bodies or refined patches and non-periodic, non-convective left/right walls)\n";
+#else
+	output << "Temporal Blocking = OFF\n";
+#endif
+
+	// Slab decomposition
+#ifdef MPI_SLABS
+	output << "MPI Slabs = " << nRanks << " ranks\n";
 #else
-	output << "Inlet Ramp = OFF\n";
+	output << "MPI Slabs = OFF\n";
 #endif
 
+	// Local grid refinement
+	if (patch.empty() == false)
+		output << "Refined Patches = " << patch.size() << " levels\n";
+	else
+		output << "Refined Patches = OFF\n";
+
 	// Universal epsilon calculation
-#ifdef UNI_EPSILON
-	output << "Universal Epsilon Calculation = ON\n";
+	if (uniEpsilon == true)
+		output << "Universal Epsilon Calculation = ON\n";
+	else
+		output << "Universal Epsilon Calculation = OFF\n";
+
+	// Lazy epsilon recomputation
+#ifdef LAZY_EPSILON
+	output << "Lazy Epsilon = " << LAZY_EPSILON << " Dx\n";
 #else
-	output << "Universal Epsilon Calculation = OFF\n";
+	output << "Lazy Epsilon = OFF\n";
 #endif
 
 	// Ordered reductions
@@ -679,49 +2272,49 @@ void GridClass::writeLog() {
 #endif
 
 	// Initial deflect
-#ifdef INITIAL_DEFLECT
-	output << "Initial Deflection = " << 100*INITIAL_DEFLECT << " %L\n";
-#else
-	output << "Initial Deflection = OFF\n";
-#endif
+	if (initialDeflection != 0.0)
+		output << "Initial Deflection = " << 100*initialDeflection << " %L\n";
+	else
+		output << "Initial Deflection = OFF\n";
 
 	// Womersley flow
-#ifdef WOMERSLEY
-	output << "Womersley Number = " << WOMERSLEY << "\n";
-#else
-	output << "Womersley Number = OFF\n";
-#endif
+	if (womersley > 0.0)
+		output << "Womersley Number = " << womersley << "\n";
+	else
+		output << "Womersley Number = OFF\n";
+
+	// LES model
+	if (smagorinsky > 0.0)
+		output << "Smagorinsky Constant = " << smagorinsky << "\n";
+	else
+		output << "Smagorinsky Constant = OFF\n";
 
 	// OUTPUT OPTIONS
 	output << "\nOUTPUT OPTIONS:\n";
 
 	// VTK option
-#ifdef VTK
-	output << "VTK Output = ON\n";
-#else
-	output << "VTK Output = OFF\n";
-#endif
+	if (vtkOutput == true)
+		output << "VTK Output = ON\n";
+	else
+		output << "VTK Output = OFF\n";
 
 	// FEM VTK option
-#ifdef VTK_FEM
-	output << "FEM VTK Output = ON\n";
-#else
-	output << "FEM VTK Output = OFF\n";
-#endif
+	if (vtkFEMOutput == true)
+		output << "FEM VTK Output = ON\n";
+	else
+		output << "FEM VTK Output = OFF\n";
 
 	// IBM forces
-#ifdef FORCES
-	output << "Write IBM Forces = ON\n";
-#else
-	output << "Write IBM Forces = OFF\n";
-#endif
+	if (forcesOutput == true)
+		output << "Write IBM Forces = ON\n";
+	else
+		output << "Write IBM Forces = OFF\n";
 
 	// Tip
-#ifdef TIPS
-	output << "Write Tip Positions = ON\n";
-#else
-	output << "Write Tip Positions = OFF\n";
-#endif
+	if (tipsOutput == true)
+		output << "Write Tip Positions = ON\n";
+	else
+		output << "Write Tip Positions = OFF\n";
 
 	// LATTICE VALUES
 	output << "\nLATTICE VALUES:\n";
@@ -730,11 +2323,27 @@ void GridClass::writeLog() {
 	output << "omega = "  << omega << "\n";
 	output << "tau = "  << tau << "\n";
 	output << "nu = "  << nu << "\n";
+	output << "Memory = "  << bytesPerSite() << " bytes per site\n";
+#ifdef SPARSE
+	output << "Memory Saved = "  << bytesPerSite(true) - bytesPerSite() << " bytes per site (against storing every site)\n";
+#endif
 	output << "Dx = "  << Dx << "\n";
 	output << "Dt = "  << Dt << "\n";
 	output << "Dm = "  << Dm << "\n";
 	output << "Drho = "  << Drho << "\n";
 
+	// REFINED PATCHES
+	for (size_t l = 0; l < patch.size(); l++) {
+		output << "\nPATCH " << patch[l].level << ":\n";
+		output << "nx = "  << patch[l].nx << "\n";
+		output << "ny = "  << patch[l].ny << "\n";
+		output << "Origin (m) = { " << patch[l].origin[eX] << ", " << patch[l].origin[eY] << " }\n";
+		output << "omega = "  << patch[l].omega << "\n";
+		output << "Dx = "  << patch[l].Dx << "\n";
+		output << "Dt = "  << patch[l].Dt << "\n";
+		output << "Dm = "  << patch[l].Dm << "\n";
+	}
+
 	// PHYSICAL VALUES
 	output << "\nPHYSICAL VALUES:\n";
 	output << "Length (m) = " << Dx * (Nx - 1) << "\n";
@@ -748,19 +2357,18 @@ void GridClass::writeLog() {
 
 	// BOUNDARY CONDITIONS
 	output << "\nBOUNDARY CONDITIONS\n";
-	output << "Left Wall = " << Utils::getBoundaryString(WALL_LEFT) << "\n";
-	output << "Right Wall = " << Utils::getBoundaryString(WALL_RIGHT) << "\n";
-	output << "Bottom Wall = " << Utils::getBoundaryString(WALL_BOTTOM) << "\n";
-	output << "Top Wall = " << Utils::getBoundaryString(WALL_TOP) << "\n";
+	output << "Left Wall = " << Utils::getBoundaryString(wallLeft) << "\n";
+	output << "Right Wall = " << Utils::getBoundaryString(wallRight) << "\n";
+	output << "Bottom Wall = " << Utils::getBoundaryString(wallBottom) << "\n";
+	output << "Top Wall = " << Utils::getBoundaryString(wallTop) << "\n";
 
 	// TIME STEP
 	output << "\nTIME STEP:\n";
 	output << "Time = " << Dt * nSteps << " s\n";
 	output << "nSteps = " << nSteps << "\n";
 	output << "tInfo = " << tinfo << "\n";
-#ifdef VTK
-	output << "tVTK = " << tVTK << "\n";
-#endif
+	if (vtkOutput == true)
+		output << "tVTK = " << tVTK << "\n";
 	output << "tRestart = " << tRestart << "\n";
 
 	// If doing a restart then write out how many time steps for this run
@@ -786,21 +2394,133 @@ void GridClass::writeLog() {
 	output.close();
 }
 
-// Write fluid VTK
+// Write fluid VTK (every rank writes the columns it owns)
 void GridClass::writeVTK() {
 
-	// Get the endianness
-	string endianStr = (bigEndian ? "BigEndian" : "LittleEndian");
+	// File name
+	string fname = "Results/VTK/Fluid." + to_string(t) + ".vti";
 
-	// Create file
-	ofstream output;
-	output.open("Results/VTK/Fluid." + to_string(t) + ".vti", ios::binary);
+	// Build XML header (written by the first rank)
+	string header = vtkHeader(Nx, Ny, {0.0, 0.0}, Dx);
+
+	// Build XML footer
+	ostringstream output;
+
+	// Back level -> AppendedData
+	int level = 1;
+	output << "\n" << string(level, '\t') << "</AppendedData>\n";
+
+	// Back level -> VTKFile
+	level = 0;
+	output << string(level, '\t') << "</VTKFile>\n";
+	string footer = output.str();
+
+	// Open file and write header
+#ifdef MPI_SLABS
+	MPI_File file;
+	if (MPI_File_open(MPI_COMM_WORLD, fname.c_str(), MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &file) != MPI_SUCCESS)
+		ERROR("Error opening fluid VTK file...exiting");
+	MPI_File_set_size(file, 0);
+	if (rank == 0)
+		MPI_File_write_at(file, 0, header.data(), static_cast<int>(header.size()), MPI_CHAR, MPI_STATUS_IGNORE);
+#else
+	ofstream file;
+	file.open(fname, ios::binary);
 
 	// Handle failure to open
-	if (!output.is_open())
+	if (!file.is_open())
 		ERROR("Error opening fluid VTK file...exiting");
+	file << header;
+#endif
+
+	// Loop through data arrays (density, pressure and velocity)
+	unsigned long long offset = header.size();
+	for (int a = 0; a < 3; a++) {
+
+		// Get values in the columns of this rank (in file order)
+		int nComps = (a == 2 ? 3 : 1);
+		vector<double> vals;
+		vals.reserve(nComps * (iEnd - iStart) * Ny);
+		for (int j = 0; j < Ny; j++) {
+			for (int i = iStart; i < iEnd; i++) {
+
+				// ID
+				int id = siteIdx(i, j);
+
+				// Density
+				if (a == 0)
+					vals.push_back(rho[id] * Drho);
+
+				// Pressure
+				else if (a == 1)
+					vals.push_back(ref_P + (rho[id] - rho_p / Drho) * SQ(c_s) * Dm / (Dx * SQ(Dt)));
+
+				// Velocity
+				else {
+					vals.push_back(u[id * dims + eX] * (Dx / Dt));
+					vals.push_back(u[id * dims + eY] * (Dx / Dt));
+					vals.push_back(0.0);
+				}
+			}
+		}
+
+		// Size of data array
+		unsigned long long size = static_cast<unsigned long long>(nComps) * Nx * Ny * sizeof(double);
+
+		// Write size then values (each rank writes its part of every row)
+#ifdef MPI_SLABS
+		if (rank == 0)
+			MPI_File_write_at(file, offset, &size, sizeof(unsigned long long), MPI_BYTE, MPI_STATUS_IGNORE);
+		MPI_Datatype slab;
+		int sizes[2] = {Ny, nComps * Nx};
+		int subSizes[2] = {Ny, nComps * (iEnd - iStart)};
+		int starts[2] = {0, nComps * iStart};
+		MPI_Type_create_subarray(2, sizes, subSizes, starts, MPI_ORDER_C, MPI_DOUBLE, &slab);
+		MPI_Type_commit(&slab);
+		MPI_File_set_view(file, offset + sizeof(unsigned long long), MPI_DOUBLE, slab, "native", MPI_INFO_NULL);
+		MPI_File_write_all(file, vals.data(), static_cast<int>(vals.size()), MPI_DOUBLE, MPI_STATUS_IGNORE);
+		MPI_File_set_view(file, 0, MPI_BYTE, MPI_BYTE, "native", MPI_INFO_NULL);
+		MPI_Type_free(&slab);
+#else
+		file.write((char*)&size, sizeof(unsigned long long));
+		file.write((char*)vals.data(), vals.size() * sizeof(double));
+#endif
+		offset += sizeof(unsigned long long) + size;
+	}
+
+	// Write footer and close file
+#ifdef MPI_SLABS
+	if (rank == 0)
+		MPI_File_write_at(file, offset, footer.data(), static_cast<int>(footer.size()), MPI_CHAR, MPI_STATUS_IGNORE);
+	MPI_File_close(&file);
+#else
+	file << footer;
+	file.close();
+#endif
+
+	// Write the refined patches
+	for (size_t l = 0; l < patch.size(); l++)
+		writePatchVTK(patch[l]);
+
+	// Check if we should write some blank VTK files for the body (only one rank)
+	if (rank == 0 && !oPtr->hasIBM && boost::filesystem::exists("Results/VTK/IBM.0.vtp")) {
+		fname = "Results/VTK/IBM." + to_string(t) + string(".vtp");
+		oPtr->writeEmptyVTK(fname);
+	}
+	if (rank == 0 && vtkFEMOutput == true && !oPtr->hasFlex && boost::filesystem::exists("Results/VTK/FEM.0.vtp")) {
+		fname = "Results/VTK/FEM." + to_string(t) + string(".vtp");
+		oPtr->writeEmptyVTK(fname);
+	}
+}
+
+// Header of an image VTK file (up to the start of the raw data)
+string GridClass::vtkHeader(int nx, int ny, const array<double, dims> &origin, double spacing) const {
 
-	// Write XML header
+	// Get the endianness
+	string endianStr = (bigEndian ? "BigEndian" : "LittleEndian");
+
+	// Build XML header
+	ostringstream output;
 	output << "<?xml version=\"1.0\"?>\n";
 
 	// Begin VTK file
@@ -810,13 +2530,13 @@ void GridClass::writeVTK() {
 	// New level -> ImageData
 	level = 1;
 	output << string(level, '\t') << "<ImageData "
-								  << "WholeExtent=\"" << 0.0 << " " << Nx - 1 << " " << 0.0 << " " << Ny - 1 << " " << 0.0 << " " << 0.0 << "\" "
-								  << "Origin=\"" << 0.0 << " " << 0.0 << " " << 0.0 << "\" "
-								  << "Spacing=\"" << Dx << " " << Dx << " " << Dx << "\">\n";
+								  << "WholeExtent=\"" << 0.0 << " " << nx - 1 << " " << 0.0 << " " << ny - 1 << " " << 0.0 << " " << 0.0 << "\" "
+								  << "Origin=\"" << origin[eX] << " " << origin[eY] << " " << 0.0 << "\" "
+								  << "Spacing=\"" << spacing << " " << spacing << " " << spacing << "\">\n";
 
 	// New level -> Piece
 	level = 2;
-	output << string(level, '\t') << "<Piece Extent=\"" << 0.0 << " " << Nx - 1 << " " << 0.0 << " " << Ny - 1 << " " << 0.0 << " " << 0.0 << "\">\n";
+	output << string(level, '\t') << "<Piece Extent=\"" << 0.0 << " " << nx - 1 << " " << 0.0 << " " << ny - 1 << " " << 0.0 << " " << 0.0 << "\">\n";
 
 	// New level -> PointData
 	level = 3;
@@ -829,10 +2549,10 @@ void GridClass::writeVTK() {
 	output << string(level, '\t') << "<DataArray type=\"Float64\" Name=\"Density\" format=\"appended\" offset=\"" << 0 << "\"/>\n";
 
 	// Pressure
-	output << string(level, '\t') << "<DataArray type=\"Float64\" Name=\"Pressure\" format=\"appended\" offset=\"" << 1*(Nx*Ny*sizeof(double) + sizeof(unsigned long long)) << "\"/>\n";
+	output << string(level, '\t') << "<DataArray type=\"Float64\" Name=\"Pressure\" format=\"appended\" offset=\"" << 1*(nx*ny*sizeof(double) + sizeof(unsigned long long)) << "\"/>\n";
 
 	// Velocity
-	output << string(level, '\t') << "<DataArray type=\"Float64\" Name=\"Velocity\" NumberOfComponents=\"3\" format=\"appended\" offset=\"" << 2*(Nx*Ny*sizeof(double) + sizeof(unsigned long long)) << "\"/>\n";
+	output << string(level, '\t') << "<DataArray type=\"Float64\" Name=\"Velocity\" NumberOfComponents=\"3\" format=\"appended\" offset=\"" << 2*(nx*ny*sizeof(double) + sizeof(unsigned long long)) << "\"/>\n";
 
 	// Back level -> PointData
 	level = 3;
@@ -854,115 +2574,174 @@ void GridClass::writeVTK() {
 	level = 2;
 	output << string(level, '\t') << "_";
 
-	// Density
-	unsigned long long size = Nx * Ny * sizeof(double);
-	output.write((char*)&size, sizeof(unsigned long long));
-	for (int j = 0; j < Ny; j++) {
-		for (int i = 0; i < Nx; i++) {
-			double density = rho[i * Ny + j] * Drho;
-			output.write((char*)&density, sizeof(double));
-		}
-	}
+	// Return header
+	return output.str();
+}
 
-	// Pressure
-	size = Nx * Ny * sizeof(double);
-	output.write((char*)&size, sizeof(unsigned long long));
-	for (int j = 0; j < Ny; j++) {
-		for (int i = 0; i < Nx; i++) {
-			double pressure = ref_P + (rho[i * Ny + j] - rho_p / Drho) * SQ(c_s) * Dm / (Dx * SQ(Dt));
-			output.write((char*)&pressure, sizeof(double));
-		}
-	}
+// Write patch VTK (overlaps the fluid VTK at a finer spacing)
+void GridClass::writePatchVTK(const GridPatch &p) {
 
-	// Velocity
-	size = 3 * Nx * Ny * sizeof(double);
-	output.write((char*)&size, sizeof(unsigned long long));
-	for (int j = 0; j < Ny; j++) {
-		for (int i = 0; i < Nx; i++) {
-			double ux = u[(i * Ny + j) * dims + eX] * (Dx / Dt);
-			double uy = u[(i * Ny + j) * dims + eY] * (Dx / Dt);
-			double uz = 0.0;
-			output.write((char*)&ux, sizeof(double));
-			output.write((char*)&uy, sizeof(double));
-			output.write((char*)&uz, sizeof(double));
-		}
-	}
+	// Open file
+	ofstream file;
+	file.open("Results/VTK/Patch" + to_string(p.level) + "." + to_string(t) + ".vti", ios::binary);
 
-	// Back level -> AppendedData
-	level = 1;
-	output << "\n" << string(level, '\t') << "</AppendedData>\n";
+	// Handle failure to open
+	if (!file.is_open())
+		ERROR("Error opening patch VTK file...exiting");
 
-	// Back level -> VTKFile
-	level = 0;
-	output << string(level, '\t') << "</VTKFile>\n";
+	// Write header
+	file << vtkHeader(p.nx, p.ny, p.origin, p.Dx);
 
-	// Close file
-	output.close();
+	// Loop through data arrays (density, pressure and velocity)
+	for (int a = 0; a < 3; a++) {
 
-	// Check if we should write some blank VTK files for the body
-	if (!oPtr->hasIBM && boost::filesystem::exists("Results/VTK/IBM.0.vtp")) {
-		string fname = "Results/VTK/IBM." + to_string(t) + string(".vtp");
-		oPtr->writeEmptyVTK(fname);
-	}
-#ifdef VTK_FEM
-	if (!oPtr->hasFlex && boost::filesystem::exists("Results/VTK/FEM.0.vtp")) {
-		string fname = "Results/VTK/FEM." + to_string(t) + string(".vtp");
-		oPtr->writeEmptyVTK(fname);
+		// Get values (in file order)
+		int nComps = (a == 2 ? 3 : 1);
+		vector<double> vals;
+		vals.reserve(nComps * p.nx * p.ny);
+		for (int fj = 0; fj < p.ny; fj++) {
+			for (int fi = 0; fi < p.nx; fi++) {
+
+				// ID
+				int id = fi * p.ny + fj;
+
+				// Density
+				if (a == 0)
+					vals.push_back(p.rho[id] * Drho);
+
+				// Pressure
+				else if (a == 1)
+					vals.push_back(ref_P + (p.rho[id] - rho_p / Drho) * SQ(c_s) * p.Dm / (p.Dx * SQ(p.Dt)));
+
+				// Velocity
+				else {
+					vals.push_back(p.u[id * dims + eX] * (p.Dx / p.Dt));
+					vals.push_back(p.u[id * dims + eY] * (p.Dx / p.Dt));
+					vals.push_back(0.0);
+				}
+			}
+		}
+
+		// Write size then values
+		unsigned long long size = vals.size() * sizeof(double);
+		file.write((char*)&size, sizeof(unsigned long long));
+		file.write((char*)vals.data(), size);
 	}
-#endif
+
+	// Write footer and close file
+	file << "\n\t</AppendedData>\n</VTKFile>\n";
+	file.close();
 }
 
 // Initialise grid values
 void GridClass::initialiseGrid() {
 
 	// First check to make we don't have convective BC anywhere other than RHS
-	if (WALL_LEFT == eConvective || WALL_BOTTOM == eConvective || WALL_TOP == eConvective)
+	if (wallLeft == eConvective || wallBottom == eConvective || wallTop == eConvective)
 		ERROR("Currently convective BC only supported for right boundary...exiting");
-	else if (WALL_RIGHT == eConvective)
+	else if (wallRight == eConvective)
 		delU.resize(Ny * dims, 0.0);
 
-	// Set type matrix
-	for (int i = 0; i < Nx; i++) {
+	// Set type matrix (columns of this rank)
+	for (int i = iStart; i < iEnd; i++) {
 		for (int j = 0; j < Ny; j++) {
 
 			// Get id
-			int id = i * Ny + j;
+			int id = siteIdx(i, j);
+
+			// Solid sites share one site (sparse lattice)
+			if (type[id] == eSolid)
+				continue;
 
 			// Left wall
 			if (i == 0)
-				type[id] = WALL_LEFT;
+				type[id] = wallLeft;
 
 			// Right wall
 			else if (i == Nx - 1)
-				type[id] = WALL_RIGHT;
+				type[id] = wallRight;
 
 			// Bottom wall
 			if (j == 0)
-				type[id] = WALL_BOTTOM;
+				type[id] = wallBottom;
 
 			// Top wall
 			else if (j == Ny - 1)
-				type[id] = WALL_TOP;
+				type[id] = wallTop;
 
 			// Add to the BC vector
-			if (type[id] != eFluid)
+			if (type[id] != eFluid && type[id] != eSolid)
 				BCVec.push_back(id);
 		}
 	}
 
+	// Group BC sites and build their descriptors
+	buildBCDescriptors();
+
+	// Lean memory setup (BC values are kept apart from the start of timestep values)
+#ifdef LEAN_MEMORY
+#ifdef FUSED
+	if (womersley > 0.0)
+		ERROR("Lean memory is not supported with a Womersley pressure gradient in the fused kernel...exiting");
+#endif
+	if (womersley > 0.0 && (gravityX != 0.0 || gravityY != 0.0))
+		ERROR("Lean memory is not supported with gravity and a Womersley pressure gradient (gravity is weighted by the density at each site)...exiting");
+	uBC.resize(BCVec.size() * dims, 0.0);
+	rhoBC.resize(BCVec.size(), 1.0);
+#endif
+
+	// Fused kernel setup (BC sites are always deferred)
+#ifdef FUSED
+	deferPos.resize(nSites, -1);
+	for (size_t bc = 0; bc < BCVec.size(); bc++) {
+		deferPos[BCVec[bc]] = static_cast<int>(bc);
+		deferVec.push_back(BCVec[bc]);
+	}
+#endif
+
+	// Build list of ghost layer copies
+#ifdef HALO
+	for (int i = 0; i < NxPad; i++) {
+		for (int j = 0; j < NyPad; j++) {
+
+			// Only ghost sites
+			if (i != 0 && i != NxPad - 1 && j != 0 && j != NyPad - 1)
+				continue;
+
+			// Periodic image of ghost site
+			int iImage = (i == 0 ? Nx : (i == NxPad - 1 ? 1 : i));
+			int jImage = (j == 0 ? Ny : (j == NyPad - 1 ? 1 : j));
+
+			// Copy populations that were pushed in from the lattice
+			for (int v = 0; v < nVels; v++) {
+				int iSrc = i - c[v * dims + eX];
+				int jSrc = j - c[v * dims + eY];
+				if (iSrc >= 1 && iSrc <= Nx && jSrc >= 1 && jSrc <= Ny)
+					haloVec.push_back({layoutIdx(i * NyPad + j, v), layoutIdx(iImage * NyPad + jImage, v)});
+			}
+		}
+	}
+#endif
+
+	// Moment storage setup (only BC sites keep populations)
+#ifdef MOMENTS
+	if (collisionType != eBGK)
+		ERROR("Moment storage is only supported with the BGK collision operator...exiting");
+	f.resize(BCVec.size() * nVels, 0.0);
+	fColumns.resize(omp_get_max_threads() * 3 * Ny * nVels);
+#endif
+
 	// Loop through and set inlet profile
 	for (int j = 0; j < Ny; j++) {
 
-#ifndef PROFILE
-
 		// Set initial velocity to be uniform
-		u_in[j * dims + eX] = uxInlet_p * Dt / Dx;
-		u_in[j * dims + eY] = uyInlet_p * Dt / Dx;
-
+		if (profile == eUniform) {
+			u_in[j * dims + eX] = uxInlet_p * Dt / Dx;
+			u_in[j * dims + eY] = uyInlet_p * Dt / Dx;
+		}
 
-#else
 		// Generate velocity profile
-		if (PROFILE == eParabolic) {
+		else if (profile == eParabolic) {
 
 			// Get parameters for working out parabolic profile
 			double R = height_p / 2.0;
@@ -972,7 +2751,7 @@ void GridClass::initialiseGrid() {
 			u_in[j * dims + eX] = 1.5 * (uxInlet_p * Dt / Dx) * (1.0 - SQ(YPos / R));
 			u_in[j * dims + eY] = 1.5 * (uyInlet_p * Dt / Dx) * (1.0 - SQ(YPos / R));
 		}
-		else if (PROFILE == eShear) {
+		else if (profile == eShear) {
 
 			// Get parameters for working out shear profile
 			double H = height_p;
@@ -982,7 +2761,7 @@ void GridClass::initialiseGrid() {
 			u_in[j * dims + eX] = (uxInlet_p * Dt / Dx) * (YPos / H);
 			u_in[j * dims + eY] = (uyInlet_p * Dt / Dx) * (YPos / H);
 		}
-		else if (PROFILE == eBoundaryLayer) {
+		else if (profile == eBoundaryLayer) {
 
 			// Get parameters for working out shear profile
 			double H = height_p;
@@ -992,35 +2771,35 @@ void GridClass::initialiseGrid() {
 			u_in[j * dims + eX] = ((1.5 * uxInlet_p * Dt / Dx) / SQ(H)) * YPos * (2.0 * H - YPos);
 			u_in[j * dims + eY] = ((1.5 * uyInlet_p * Dt / Dx) / SQ(H)) * YPos * (2.0 * H - YPos);
 		}
-#endif
 	}
 
 	// Set initial velocity
-	for (int i = 0; i < Nx; i++) {
+	for (int i = iStart; i < iEnd; i++) {
 		for (int j = 0; j < Ny; j++) {
 
 			// Get id
-			int id = i * Ny + j;
+			int id = siteIdx(i, j);
 
-#ifdef INLET_RAMP
-			u[id * dims + eX] = 0.0;
-			u[id * dims + eY] = 0.0;
-#else
-#ifdef PROFILE
+			// Start from rest if ramping up
+			if (inletRamp > 0.0) {
+				u[id * dims + eX] = 0.0;
+				u[id * dims + eY] = 0.0;
+			}
 
 			// Set velocity
-			u[id * dims + eX] = u_in[j * dims + eX];
-			u[id * dims + eY] = u_in[j * dims + eY];
-#else
+			else if (profile != eUniform) {
+				u[id * dims + eX] = u_in[j * dims + eX];
+				u[id * dims + eY] = u_in[j * dims + eY];
+			}
 
 			// Set initial velocity to be uniform
-			u[id * dims + eX] = ux0_p * Dt / Dx;
-			u[id * dims + eY] = uy0_p * Dt / Dx;
-#endif
-#endif
+			else {
+				u[id * dims + eX] = ux0_p * Dt / Dx;
+				u[id * dims + eY] = uy0_p * Dt / Dx;
+			}
 
-			// If a wall then set to zero
-			if (type[id] == eWall) {
+			// If a wall or solid then set to zero
+			if (type[id] == eWall || type[id] == eSolid) {
 				u[id * dims + eX] = 0.0;
 				u[id * dims + eY] = 0.0;
 			}
@@ -1028,37 +2807,423 @@ void GridClass::initialiseGrid() {
 	}
 
 	// Set start of time step values
-	u_n = u;
-	rho_n = rho;
+#ifndef LEAN_MEMORY
+	copy(u.begin() + idStart * dims, u.begin() + idEnd * dims, u_n.begin() + idStart * dims);
+	copy(rho.begin() + idStart, rho.begin() + idEnd, rho_n.begin() + idStart);
+#endif
 
-	// Set the xy forces
-	for (int i = 0; i < Nx; i++) {
+	// Set the xy forces (same as the refined patches and one value for all sites with lean memory)
+	array<double, dims> forceXY = levelForceXY(0);
+#ifdef LEAN_MEMORY
+	bodyForce = forceXY;
+#else
+	for (int i = iStart; i < iEnd; i++) {
 		for (int j = 0; j < Ny; j++) {
 
 			// ID
-			int id = i * Ny + j;
+			int id = siteIdx(i, j);
 
 			// Set the xyz cartesian forces
-			force_xy[id * dims + eX] = (rho[id] * Drho * gravityX + dpdx) * SQ(Dx * Dt) / Dm;
-			force_xy[id * dims + eY] = (rho[id] * Drho * gravityY + dpdy) * SQ(Dx * Dt) / Dm;
+			force_xy[id * dims + eX] = forceXY[eX];
+			force_xy[id * dims + eY] = forceXY[eY];
 		}
 	}
+#endif
 
 	// Set f values to equilibrium
-	for (int i = 0; i < Nx; i++) {
+	for (int i = iStart; i < iEnd; i++) {
 		for (int j = 0; j < Ny; j++) {
 
 			// ID
-			int id = i * Ny + j;
+			int id = siteIdx(i, j);
 
 			// Loop though vels
+			array<double, nVels> fPop;
 			for (int v = 0; v < nVels; v++)
-				f[id * nVels + v] = equilibrium(id, v);
+				fPop[v] = (collisionType == eCentralMoments ? equilibrium<eCentralMoments>(id, v) : equilibrium<eBGK>(id, v));
+			putPostStream(id, fPop);
 		}
 	}
 
 	// Set start of time step values
-	f_n = f;
+#if !defined AA_PATTERN && !defined MOMENTS
+	for (int sid = sidStart; sid < sidEnd; sid++) {
+		for (int v = 0; v < nVels; v++)
+			f_n[layoutIdx(sid, v)] = f[layoutIdx(sid, v)];
+	}
+#endif
+
+	// Fused kernel holds post-collision populations
+#ifdef FUSED
+	(this->*kernels.initial)();
+#endif
+}
+
+// Group BC sites by type and normal and build their descriptors
+void GridClass::buildBCDescriptors() {
+
+	// Build descriptor of each BC site
+	vector<BCDescriptor> descVec(BCVec.size());
+	for (size_t bc = 0; bc < BCVec.size(); bc++) {
+
+		// Get position and normal
+		BCDescriptor &desc = descVec[bc];
+		array<int, dims> pos = sitePos(BCVec[bc]);
+		desc.i = pos[eX];
+		desc.j = pos[eY];
+		desc.normal = getNormalVector(desc.i, desc.j, desc.normalDirection);
+		desc.corner = (desc.normal[eX] != 0 && desc.normal[eY] != 0);
+
+		// Get sites along the normal (values are extrapolated from them)
+		for (int n = 0; n < 3; n++)
+			desc.inward[n] = siteIdx(desc.i + (n + 1) * desc.normal[eX], desc.j + (n + 1) * desc.normal[eY]);
+
+		// Get unknown links
+		desc.unknownMask = 0;
+		desc.buriedMask = 0;
+		for (int v = 0; v < nVels; v++) {
+
+			// If corner then unknowns share at least one of normal components (buried if along the wall)
+			if (desc.corner == true) {
+				if (c[v * dims + eX] == desc.normal[eX] || c[v * dims + eY] == desc.normal[eY]) {
+					desc.unknownMask |= (1 << v);
+					if (desc.normal[eX] * c[v * dims + eX] + desc.normal[eY] * c[v * dims + eY] == 0)
+						desc.buriedMask |= (1 << v);
+				}
+			}
+
+			// If other then unknowns share the normal vector component
+			else if (c[v * dims + desc.normalDirection] == desc.normal[desc.normalDirection]) {
+				desc.unknownMask |= (1 << v);
+			}
+		}
+	}
+
+	// Group key of a BC site (edges before corners)
+	auto groupKey = [&](int bc) {
+		return make_tuple(descVec[bc].corner, type[BCVec[bc]], descVec[bc].normal[eX], descVec[bc].normal[eY]);
+	};
+
+	// Sort sites into groups
+	vector<int> order(BCVec.size());
+	for (size_t bc = 0; bc < BCVec.size(); bc++)
+		order[bc] = static_cast<int>(bc);
+	stable_sort(order.begin(), order.end(), [&](int a, int b) {return groupKey(a) < groupKey(b);});
+
+	// Store sites in group order and mark start of each group
+	vector<int> idVec(BCVec.size());
+	BCDesc.resize(BCVec.size());
+	BCGroup.clear();
+	for (size_t bc = 0; bc < BCVec.size(); bc++) {
+		idVec[bc] = BCVec[order[bc]];
+		BCDesc[bc] = descVec[order[bc]];
+		if (bc == 0 || groupKey(order[bc]) != groupKey(order[bc - 1]))
+			BCGroup.push_back(static_cast<int>(bc));
+	}
+	BCGroup.push_back(static_cast<int>(BCVec.size()));
+	BCVec.swap(idVec);
+
+	// Get position of each site in BCVec
+	BCPos.assign(nSites, -1);
+	for (size_t bc = 0; bc < BCVec.size(); bc++)
+		BCPos[BCVec[bc]] = static_cast<int>(bc);
+}
+
+// Read solid sites of the slab from a greyscale image of the lattice (dark pixels are solid, top row of the image is the top of the lattice)
+void GridClass::readSolidMask(vector<char> &solid) {
+
+	// Open file (no mask means no solid sites)
+	ifstream file;
+	file.open("input/solid.pgm", ios::binary);
+	if (!file.is_open())
+		return;
+
+	// Read header values (skipping comments)
+	string magic;
+	array<int, 3> header;
+	file >> magic;
+	for (int n = 0; n < 3; n++) {
+		file >> ws;
+		while (file.peek() == '#') {
+			file.ignore(numeric_limits<streamsize>::max(), '\n');
+			file >> ws;
+		}
+		file >> header[n];
+	}
+
+	// Check the image matches the lattice
+	if (!file || (magic != "P2" && magic != "P5") || header[2] <= 0 || header[2] > 255)
+		ERROR("Error reading solid.pgm (must be an 8-bit P2 or P5 image)...exiting");
+	if (header[0] != Nx || header[1] != Ny)
+		ERROR("Solid mask is " + to_string(header[0]) + "x" + to_string(header[1]) + " but lattice is " + to_string(Nx) + "x" + to_string(Ny) + "...exiting");
+
+	// Skip the single whitespace before binary data
+	if (magic == "P5")
+		file.get();
+
+	// Read pixels
+	for (int r = 0; r < Ny; r++) {
+		for (int i = 0; i < Nx; i++) {
+
+			// Get pixel value
+			int value;
+			if (magic == "P5")
+				value = file.get();
+			else
+				file >> value;
+			if (!file)
+				ERROR("Error reading solid.pgm (not enough pixels)...exiting");
+
+			// Dark pixels are solid (only the columns of this rank are kept)
+			if (ownsColumn(i))
+				solid[(i - iStart) * Ny + (Ny - 1 - r)] = (value < (header[2] + 1) / 2 ? 1 : 0);
+		}
+	}
+}
+
+// Number the non-solid sites in runs up each column
+void GridClass::buildSparse() {
+
+	// Read in solid sites of the slab (if there is a mask)
+	vector<char> solid((iEnd - iStart) * Ny, 0);
+	readSolidMask(solid);
+
+	// Number the non-solid sites column by column
+	int nStored = 0;
+	sparseRun.clear();
+	sparseCol.assign(1, 0);
+	for (int i = iStart; i < iEnd; i++) {
+		for (int j = 0; j < Ny; j++) {
+
+			// Start a new run or add to the last one
+			int s = (i - iStart) * Ny + j;
+			if (solid[s] == 0) {
+				if (j == 0 || solid[s - 1] != 0)
+					sparseRun.push_back({j, j + 1, nStored});
+				else
+					sparseRun.back()[1]++;
+				nStored++;
+			}
+		}
+		sparseCol.push_back(static_cast<int>(sparseRun.size()));
+	}
+
+	// Solid sites all share one site after the stored ones (it is never streamed or collided)
+	nSites = nStored + 1;
+	idStart = 0;
+	idEnd = nStored;
+
+	// Size the population arrays (memory is not touched yet)
+	f.resize(nStored * nVels);
+	f_n.resize(nStored * nVels);
+	sidStart = 0;
+	sidEnd = nStored;
+
+	// Three columns of site IDs for each thread
+	sparseColumns.resize(omp_get_max_threads() * 3 * Ny);
+}
+
+// Build nested patches around a box (each level twice as fine as its parent, the margin grows by one for each coarser level)
+void GridClass::refineAround(const array<double, dims> &lo, const array<double, dims> &hi, int nLevels, double margin) {
+
+	// Check the options are supported
+	if (nRanks > 1)
+		ERROR("Refined patches are not supported with MPI slabs...exiting");
+#if defined FUSED || defined MOMENTS || defined SPARSE
+	ERROR("Refined patches are not supported with the fused kernel, moment storage or sparse lattice...exiting");
+#endif
+	if (womersley > 0.0)
+		ERROR("Refined patches are not supported with a Womersley pressure gradient...exiting");
+
+	// Write out
+	cout << endl << "Building " << nLevels << " refined patches...";
+
+	// Loop through levels
+	patch.reserve(nLevels);
+	for (int l = 1; l <= nLevels; l++) {
+
+		// Parent values
+		array<double, dims> originPar = levelOrigin(l - 1);
+		double DxPar = levelDx(l - 1);
+		double DtPar = (l == 1 ? Dt : patch[l - 2].Dt);
+		double DmPar = (l == 1 ? Dm : patch[l - 2].Dm);
+		double tauPar = 1.0 / levelOmega(l - 1);
+		int NyPar = levelNy(l - 1);
+
+		// Get parent sites around the box
+		GridPatch p;
+		double pad = margin * (nLevels - l + 1);
+		p.level = l;
+		p.i0 = static_cast<int>(floor((lo[eX] - pad - originPar[eX]) / DxPar));
+		p.j0 = static_cast<int>(floor((lo[eY] - pad - originPar[eY]) / DxPar));
+		int i1 = static_cast<int>(ceil((hi[eX] + pad - originPar[eX]) / DxPar));
+		int j1 = static_cast<int>(ceil((hi[eY] + pad - originPar[eY]) / DxPar));
+
+		// Patch (and the ring outside it) must sit clear of the parent edges
+		if (p.i0 < 2 || i1 > levelNx(l - 1) - 3 || p.j0 < 2 || j1 > NyPar - 3)
+			ERROR("Refined patch " + to_string(l) + " does not fit inside its parent (reduce the REFINE margin)...exiting");
+
+		// Set sizes and scalings (acoustic scaling so velocity and pressure convert the same on every level)
+		p.nx = 2 * (i1 - p.i0) + 1;
+		p.ny = 2 * (j1 - p.j0) + 1;
+		p.origin = {originPar[eX] + p.i0 * DxPar, originPar[eY] + p.j0 * DxPar};
+		p.Dx = DxPar / 2.0;
+		p.Dt = DtPar / 2.0;
+		p.Dm = DmPar / 8.0;
+		p.omega = 1.0 / (0.5 + 2.0 * (tauPar - 0.5));
+		p.forceXY = {(Drho * gravityX + dpdx) * SQ(p.Dx * p.Dt) / p.Dm, (Drho * gravityY + dpdy) * SQ(p.Dx * p.Dt) / p.Dm};
+
+		// Size arrays
+		p.f.resize(p.nx * p.ny * nVels, 0.0);
+		p.f_n.resize(p.nx * p.ny * nVels, 0.0);
+		p.u.resize(p.nx * p.ny * dims, 0.0);
+		p.u_n.resize(p.nx * p.ny * dims, 0.0);
+		p.rho.resize(p.nx * p.ny, 1.0);
+		p.rho_n.resize(p.nx * p.ny, 1.0);
+		p.force_ibm.resize(p.nx * p.ny * dims, 0.0);
+		p.forceMask.resize(p.nx * p.ny, 0);
+
+		// Get position of a parent site in the ring (adding it if it is new)
+		map<int, int> ringPos;
+		auto ring = [&](int pi, int pj) {
+			int pid = levelSiteIdx(l - 1, pi, pj);
+			if (ringPos.count(pid) == 0) {
+				ringPos[pid] = static_cast<int>(p.ringSites.size());
+				p.ringSites.push_back(pid);
+			}
+			return ringPos[pid];
+		};
+
+		// Loop through patch edge sites
+		for (int fi = 0; fi < p.nx; fi++) {
+			for (int fj = 0; fj < p.ny; fj++) {
+
+				// Only edge sites
+				if (fi != 0 && fi != p.nx - 1 && fj != 0 && fj != p.ny - 1)
+					continue;
+
+				// Get the parent line the site sits on and the position along it
+				bool alongX = (fj == 0 || fj == p.ny - 1);
+				int pi = p.i0 + (fi == 0 ? 0 : i1 - p.i0);
+				int pj = p.j0 + (fj == 0 ? 0 : j1 - p.j0);
+				int n = (alongX == true ? fi : fj);
+
+				// Coincident sites copy the parent, the others use a cubic through four parent sites
+				array<int, 4> from = {0, 0, 0, 0};
+				array<double, 4> weight = {0.0, 0.0, 0.0, 0.0};
+				if (n % 2 == 0) {
+					from[0] = (alongX == true ? ring(p.i0 + n / 2, pj) : ring(pi, p.j0 + n / 2));
+					weight[0] = 1.0;
+				}
+				else {
+					for (int k = 0; k < 4; k++) {
+						int a = (n - 1) / 2 - 1 + k;
+						from[k] = (alongX == true ? ring(p.i0 + a, pj) : ring(pi, p.j0 + a));
+						weight[k] = (k == 0 || k == 3 ? -1.0 / 16.0 : 9.0 / 16.0);
+					}
+				}
+
+				// Add to edge list
+				p.edgeSites.push_back(fi * p.ny + fj);
+				p.edgeFrom.push_back(from);
+				p.edgeWeight.push_back(weight);
+			}
+		}
+
+		// Size ring arrays
+		p.fRing.resize(p.ringSites.size() * nVels, 0.0);
+		p.fRing_n.resize(p.ringSites.size() * nVels, 0.0);
+
+		// Add patch and fill it from its parent
+		patch.push_back(p);
+		initialisePatch(patch.back());
+	}
+}
+
+// Interpolate patch values from its parent (bilinear in space)
+void GridClass::initialisePatch(GridPatch &p) {
+
+	// Parent values
+	array<double, dims> FPar = levelForceXY(p.level - 1);
+	double ratio = levelOmega(p.level - 1) / (2.0 * p.omega);
+
+	// Reset IBM force
+	fill(p.force_ibm.begin(), p.force_ibm.end(), 0.0);
+	fill(p.forceMask.begin(), p.forceMask.end(), 0);
+	p.forceSites.clear();
+
+	// Loop through patch sites
+	for (int fi = 0; fi < p.nx; fi++) {
+		for (int fj = 0; fj < p.ny; fj++) {
+
+			// ID
+			int id = fi * p.ny + fj;
+
+			// Parent site below and to the left and distance from it
+			int pi = p.i0 + fi / 2;
+			int pj = p.j0 + fj / 2;
+			double wx = 0.5 * (fi % 2);
+			double wy = 0.5 * (fj % 2);
+
+			// Interpolate parent populations
+			array<double, nVels> fPar = {0.0};
+			for (int a = 0; a < 2; a++) {
+				for (int b = 0; b < 2; b++) {
+
+					// Weight
+					double weight = (a == 0 ? 1.0 - wx : wx) * (b == 0 ? 1.0 - wy : wy);
+					if (weight == 0.0)
+						continue;
+
+					// Add
+					array<double, nVels> fPop;
+					getLevelPops(p.level - 1, levelSiteIdx(p.level - 1, pi + a, pj + b), fPop.data());
+					for (int v = 0; v < nVels; v++)
+						fPar[v] += weight * fPop[v];
+				}
+			}
+
+			// Rescale to the patch
+			if (collisionType == eBGK)
+				rescalePops<eBGK>(fPar.data(), FPar, p.forceXY, ratio, &p.f[id * nVels]);
+			else
+				rescalePops<eCentralMoments>(fPar.data(), FPar, p.forceXY, ratio, &p.f[id * nVels]);
+
+			// Get macroscopic values
+			patchMacroscopic(p, id, false);
+		}
+	}
+
+	// Start of sub-step values
+	p.f_n = p.f;
+	p.u_n = p.u;
+	p.rho_n = p.rho;
+
+	// Parent populations on the ring
+	for (size_t r = 0; r < p.ringSites.size(); r++)
+		getLevelPops(p.level - 1, p.ringSites[r], &p.fRing_n[r * nVels]);
+}
+
+// Memory held by the lattice arrays per lattice site, or that they would hold if every site was stored (refined patches not included)
+double GridClass::bytesPerSite(bool dense) const {
+
+	// Arrays with an entry for each stored site
+	size_t siteBytes = (u.size() + u_n.size() + rho.size() + rho_n.size() + force_xy.size() + force_ibm.size() + mom.size() + mom_n.size()) * sizeof(double);
+	siteBytes += forceMask.size() * sizeof(char) + type.size() * sizeof(eLatType) + (f.size() + f_n.size()) * sizeof(popType);
+	siteBytes += (BCPos.size() + deferPos.size()) * sizeof(int);
+
+	// Buffers and BC and fused kernel site lists
+	size_t listBytes = (fColumns.size() + uBC.size() + rhoBC.size() + f_out.size() + fDefer.size()) * sizeof(double);
+	listBytes += (BCVec.size() + deferVec.size() + sparseColumns.size()) * sizeof(int) + BCDesc.size() * sizeof(BCDescriptor) + haloVec.size() * sizeof(array<int, 2>);
+
+	// Sparse lattice runs
+	size_t sparseBytes = sparseRun.size() * sizeof(array<int, 3>) + sparseCol.size() * sizeof(int);
+
+	// Per lattice site of the slab of this rank
+	double nSlab = static_cast<double>(iEnd - iStart) * Ny;
+	if (dense == true)
+		return static_cast<double>(siteBytes) / static_cast<double>(nSites) + static_cast<double>(listBytes) / nSlab;
+	return static_cast<double>(siteBytes + listBytes + sparseBytes) / nSlab;
 }
 
 // Start the clock for getting MLUPS
@@ -1108,12 +3273,16 @@ void GridClass::readRestart() {
 	tOffset = (bigEndian ? Utils::swapEnd(tRead) : tRead);
 	t = tOffset;
 
-	// Now loop through each lattice site and read necessary data
-	for (int i = 0; i < Nx; i++) {
+	// Skip to the sites of this rank
+	streamoff siteBytes = 2 * sizeof(int) + (5 + nVels) * sizeof(double);
+	file.seekg(static_cast<streamoff>(iStart) * Ny * siteBytes, ios::cur);
+
+	// Now loop through each lattice site in the slab and read necessary data
+	for (int i = iStart; i < iEnd; i++) {
 		for (int j = 0; j < Ny; j++) {
 
 			// ID
-			int id = i * Ny + j;
+			int id = siteIdx(i, j);
 
 			// Declare values
 			int iRead, jRead;
@@ -1141,6 +3310,12 @@ void GridClass::readRestart() {
 			if (i != iSwap || j != jSwap)
 				ERROR("Grid indices do not match Fluid.restart file...exiting");
 
+			// Solid sites share one site which keeps its initial values (sparse lattice)
+			if (type[id] == eSolid) {
+				file.seekg(nVels * sizeof(double), ios::cur);
+				continue;
+			}
+
 			// Read into grid data
 			rho[id] = rhoSwap;
 			u[id * dims + eX] = uxSwap;
@@ -1148,27 +3323,49 @@ void GridClass::readRestart() {
 			force_ibm[id * dims + eX] = fxSwap;
 			force_ibm[id * dims + eY] = fySwap;
 
+			// Mark sites with an IBM force
+			if (fxSwap != 0.0 || fySwap != 0.0) {
+				forceMask[id] = 1;
+				forceSites.push_back(id);
+			}
+
 			// Read in f values
+			array<double, nVels> fPop;
 			for (int v = 0; v < nVels; v++) {
 				double fRead;
 				file.read((char*)&fRead, sizeof(double));
-				double fSwap = (bigEndian ? Utils::swapEnd(fRead) : fRead);
-				f[id * nVels + v] = fSwap;
+				fPop[v] = (bigEndian ? Utils::swapEnd(fRead) : fRead);
 			}
+			putPostStream(id, fPop);
 		}
 	}
+
+	// Fused kernel holds post-collision populations
+#ifdef FUSED
+	(this->*kernels.initial)();
+#endif
+
+	// Read in the refined patches (or interpolate them from the grid again if they do not match)
+	if (patch.empty() == false && readPatchRestart() == false) {
+		for (size_t l = 0; l < patch.size(); l++)
+			initialisePatch(patch[l]);
+	}
 }
 
 // Read in restart file
 void GridClass::writeRestart() {
 
-	// Create file
+	// Create file (each rank puts its sites in a buffer first)
+#ifdef MPI_SLABS
+	ostringstream output(ios::binary);
+#else
 	ofstream output;
 	output.open("Results/Restart/Fluid.restart.temp", ios::binary);
 
 	// Handle failure to open
 	if (!output.is_open())
 		ERROR("Error opening Fluid.restart.temp file...exiting");
+#endif
 
 	// Swap byte order if bigEndian
 	int tWrite = (bigEndian ? Utils::swapEnd(t) : t);
@@ -1179,21 +3376,23 @@ void GridClass::writeRestart() {
 	double dtWrite = (bigEndian ? Utils::swapEnd(Dt) : Dt);
 	double dmWrite = (bigEndian ? Utils::swapEnd(Dm) : Dm);
 
-	// Write out global information
-	output.write((char*)&tWrite, sizeof(int));
-	output.write((char*)&nxWrite, sizeof(int));
-	output.write((char*)&nyWrite, sizeof(int));
-	output.write((char*)&omegaWrite, sizeof(double));
-	output.write((char*)&dxWrite, sizeof(double));
-	output.write((char*)&dtWrite, sizeof(double));
-	output.write((char*)&dmWrite, sizeof(double));
-
-	// Now loop through each lattice site and write necessary data
-	for (int i = 0; i < Nx; i++) {
+	// Write out global information (only one rank)
+	if (rank == 0) {
+		output.write((char*)&tWrite, sizeof(int));
+		output.write((char*)&nxWrite, sizeof(int));
+		output.write((char*)&nyWrite, sizeof(int));
+		output.write((char*)&omegaWrite, sizeof(double));
+		output.write((char*)&dxWrite, sizeof(double));
+		output.write((char*)&dtWrite, sizeof(double));
+		output.write((char*)&dmWrite, sizeof(double));
+	}
+
+	// Now loop through each lattice site in the slab and write necessary data
+	for (int i = iStart; i < iEnd; i++) {
 		for (int j = 0; j < Ny; j++) {
 
 			// ID
-			int id = i * Ny + j;
+			int id = siteIdx(i, j);
 
 			// Swap byte order if bigEndian
 			int iWrite = (bigEndian ? Utils::swapEnd(i) : i);
@@ -1214,25 +3413,196 @@ void GridClass::writeRestart() {
 			output.write((char*)&fyWrite, sizeof(double));
 
 			// Write out f values
+			array<double, nVels> fPop;
+			getPostStream(i, j, id, fPop);
 			for (int v = 0; v < nVels; v++) {
-				double fWrite = (bigEndian ? Utils::swapEnd(f[id * nVels + v]) : f[id * nVels + v]);
+				double fWrite = (bigEndian ? Utils::swapEnd(fPop[v]) : fPop[v]);
 				output.write((char*)&fWrite, sizeof(double));
 			}
 		}
 	}
 
+	// Write each buffer straight after the sites of the ranks before it
+#ifdef MPI_SLABS
+	string buffer = output.str();
+	MPI_Offset headerBytes = 3 * sizeof(int) + 4 * sizeof(double);
+	MPI_Offset siteBytes = 2 * sizeof(int) + (5 + nVels) * sizeof(double);
+	MPI_Offset offset = (rank == 0 ? 0 : headerBytes + static_cast<MPI_Offset>(iStart) * Ny * siteBytes);
+	MPI_File file;
+	if (MPI_File_open(MPI_COMM_WORLD, "Results/Restart/Fluid.restart.temp", MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &file) != MPI_SUCCESS)
+		ERROR("Error opening Fluid.restart.temp file...exiting");
+	MPI_File_set_size(file, 0);
+	MPI_File_write_at_all(file, offset, buffer.data(), static_cast<int>(buffer.size()), MPI_CHAR, MPI_STATUS_IGNORE);
+	MPI_File_close(&file);
+#else
+
 	// Close file
 	output.close();
+#endif
+
+	// Now rename the temp file (only one rank)
+	if (rank == 0)
+		boost::filesystem::rename("Results/Restart/Fluid.restart.temp", "Results/Restart/Fluid.restart");
+
+	// Write out the refined patches
+	if (patch.empty() == false)
+		writePatchRestart();
+}
+
+// Read in refined patches restart file
+bool GridClass::readPatchRestart() {
+
+	// Open file (patches are interpolated again if there is none)
+	ifstream file;
+	file.open("Results/Restart/Patches.restart", ios::binary);
+	if (!file.is_open())
+		return false;
+
+	// Read in global info
+	int tRead, nRead;
+	file.read((char*)&tRead, sizeof(int));
+	file.read((char*)&nRead, sizeof(int));
+
+	// Check they match up
+	if ((bigEndian ? Utils::swapEnd(tRead) : tRead) != tOffset || (bigEndian ? Utils::swapEnd(nRead) : nRead) != static_cast<int>(patch.size()))
+		return false;
+
+	// Loop through patches
+	for (size_t l = 0; l < patch.size(); l++) {
+
+		// Get patch
+		GridPatch &p = patch[l];
+
+		// Read in patch info
+		array<int, 4> boxRead;
+		double omegaRead, dxRead;
+		file.read((char*)boxRead.data(), 4 * sizeof(int));
+		file.read((char*)&omegaRead, sizeof(double));
+		file.read((char*)&dxRead, sizeof(double));
+
+		// Swap byte order if bigEndian
+		for (int b = 0; b < 4; b++)
+			boxRead[b] = (bigEndian ? Utils::swapEnd(boxRead[b]) : boxRead[b]);
+		double omegaSwap = (bigEndian ? Utils::swapEnd(omegaRead) : omegaRead);
+		double dxSwap = (bigEndian ? Utils::swapEnd(dxRead) : dxRead);
+
+		// Check they match up
+		if (boxRead[0] != p.i0 || boxRead[1] != p.j0 || boxRead[2] != p.nx || boxRead[3] != p.ny || omegaSwap != p.omega || dxSwap != p.Dx)
+			return false;
+
+		// Reset IBM force
+		p.forceSites.clear();
+
+		// Loop through patch sites
+		for (int id = 0; id < p.nx * p.ny; id++) {
+
+			// Read in data
+			array<double, 5 + nVels> vals;
+			file.read((char*)vals.data(), vals.size() * sizeof(double));
+			for (size_t n = 0; n < vals.size(); n++)
+				vals[n] = (bigEndian ? Utils::swapEnd(vals[n]) : vals[n]);
+
+			// Read into patch data
+			p.rho[id] = vals[0];
+			p.u[id * dims + eX] = vals[1];
+			p.u[id * dims + eY] = vals[2];
+			p.force_ibm[id * dims + eX] = vals[3];
+			p.force_ibm[id * dims + eY] = vals[4];
+			for (int v = 0; v < nVels; v++)
+				p.f[id * nVels + v] = vals[5 + v];
+
+			// Mark sites with an IBM force
+			p.forceMask[id] = (vals[3] != 0.0 || vals[4] != 0.0);
+			if (p.forceMask[id] != 0)
+				p.forceSites.push_back(id);
+		}
+
+		// Read in parent populations on the ring
+		file.read((char*)p.fRing_n.data(), p.fRing_n.size() * sizeof(double));
+		for (size_t r = 0; r < p.fRing_n.size(); r++)
+			p.fRing_n[r] = (bigEndian ? Utils::swapEnd(p.fRing_n[r]) : p.fRing_n[r]);
+	}
+
+	// Check it was all there
+	return !file.fail();
+}
+
+// Write out refined patches restart file
+void GridClass::writePatchRestart() {
+
+	// Create file
+	ofstream output;
+	output.open("Results/Restart/Patches.restart.temp", ios::binary);
+
+	// Handle failure to open
+	if (!output.is_open())
+		ERROR("Error opening Patches.restart.temp file...exiting");
+
+	// Write out global information
+	int tWrite = (bigEndian ? Utils::swapEnd(t) : t);
+	int nWrite = (bigEndian ? Utils::swapEnd(static_cast<int>(patch.size())) : static_cast<int>(patch.size()));
+	output.write((char*)&tWrite, sizeof(int));
+	output.write((char*)&nWrite, sizeof(int));
+
+	// Loop through patches
+	for (size_t l = 0; l < patch.size(); l++) {
+
+		// Get patch
+		const GridPatch &p = patch[l];
+
+		// Write out patch information
+		array<int, 4> boxWrite = {p.i0, p.j0, p.nx, p.ny};
+		for (int b = 0; b < 4; b++)
+			boxWrite[b] = (bigEndian ? Utils::swapEnd(boxWrite[b]) : boxWrite[b]);
+		double omegaWrite = (bigEndian ? Utils::swapEnd(p.omega) : p.omega);
+		double dxWrite = (bigEndian ? Utils::swapEnd(p.Dx) : p.Dx);
+		output.write((char*)boxWrite.data(), 4 * sizeof(int));
+		output.write((char*)&omegaWrite, sizeof(double));
+		output.write((char*)&dxWrite, sizeof(double));
+
+		// Loop through patch sites
+		for (int id = 0; id < p.nx * p.ny; id++) {
+
+			// Get values
+			array<double, 5 + nVels> vals = {p.rho[id], p.u[id * dims + eX], p.u[id * dims + eY], p.force_ibm[id * dims + eX], p.force_ibm[id * dims + eY]};
+			for (int v = 0; v < nVels; v++)
+				vals[5 + v] = p.f[id * nVels + v];
+
+			// Swap byte order if bigEndian and write
+			for (size_t n = 0; n < vals.size(); n++)
+				vals[n] = (bigEndian ? Utils::swapEnd(vals[n]) : vals[n]);
+			output.write((char*)vals.data(), vals.size() * sizeof(double));
+		}
 
-	// Now rename the temp file
-	boost::filesystem::rename("Results/Restart/Fluid.restart.temp", "Results/Restart/Fluid.restart");
+		// Write out parent populations on the ring
+		for (size_t r = 0; r < p.fRing_n.size(); r++) {
+			double fWrite = (bigEndian ? Utils::swapEnd(p.fRing_n[r]) : p.fRing_n[r]);
+			output.write((char*)&fWrite, sizeof(double));
+		}
+	}
+
+	// Close file and rename
+	output.close();
+	boost::filesystem::rename("Results/Restart/Patches.restart.temp", "Results/Restart/Patches.restart");
 }
 
 // Constructor
 GridClass::GridClass() {
 
-	// Create directories
-	restartFlag = Utils::createDirectories();
+	// Get rank of this process and number of ranks
+#ifdef MPI_SLABS
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+	MPI_Comm_size(MPI_COMM_WORLD, &nRanks);
+#else
+	rank = 0;
+	nRanks = 1;
+#endif
+
+	// Create directories (first rank only, the others wait to find out if it is a restart)
+	restartFlag = (rank == 0 ? Utils::createDirectories() : false);
+#ifdef MPI_SLABS
+	MPI_Bcast(&restartFlag, 1, MPI_CXX_BOOL, 0, MPI_COMM_WORLD);
+#endif
 
 	// Write out
 	cout << endl << endl << "Initialising grid...";
@@ -1240,14 +3610,36 @@ GridClass::GridClass() {
 	// Initially set objects to NULL
 	oPtr = NULL;
 
+	// Get slab of columns owned by this rank
+	iStart = rank * Nx / nRanks;
+	iEnd = (rank + 1) * Nx / nRanks;
+	if (nRanks > 1 && iEnd - iStart < 3)
+		ERROR("Each MPI rank needs at least 3 lattice columns (Nx = " + to_string(Nx) + " with " + to_string(nRanks) + " ranks)...exiting");
+
+	// Size of population storage (MPI ranks only store their slab and a ghost column either side)
+#ifdef HALO
+	NxPad = Nx + 2;
+	NyPad = Ny + 2;
+#elif defined MPI_SLABS
+	NxPad = iEnd - iStart + 2;
+	NyPad = Ny;
+#else
+	NxPad = Nx;
+	NyPad = Ny;
+#endif
+
+	// Gravity and pressure gradient force every site
+	xyForce = (gravityX != 0.0 || gravityY != 0.0 || dpdx != 0.0 || dpdy != 0.0);
+
+	// Pick the kernels for this collision operator
+	kernels = kernelTable[collisionType];
+
 	// Some default parameters
 	double rho0 = 1.0;
 
-	// D2Q9 parameters (can be hard-coded)
-	c_s = 1.0 / sqrt(3.0);
-	w = {4.0 / 9.0, 1.0 / 9.0, 1.0 / 9.0, 1.0 / 9.0, 1.0 / 9.0, 1.0 / 36.0, 1.0 / 36.0, 1.0 / 36.0, 1.0 / 36.0};
-	c = {0, 0, 1, 0, -1, 0, 0, 1, 0, -1, 1, 1, -1, -1, 1, -1, -1, 1};
-	opposite = {0, 2, 1, 4, 3, 6, 5, 8, 7};
+	// Streaming offsets
+	for (int v = 0; v < nVels; v++)
+		shift[v] = c[v * dims + eX] * NyPad + c[v * dims + eY];
 
 	// Initialise parameters
 	t = 0;
@@ -1263,16 +3655,127 @@ GridClass::GridClass() {
 	startTime = omp_get_wtime();
 	loopTime = 0.0;
 
-	// Set the sizes and initialise arrays
-	u.resize(Nx * Ny * dims, 0.0);
-	u_n.resize(Nx * Ny * dims, 0.0);
-	rho.resize(Nx * Ny, rho0);
-	rho_n.resize(Nx * Ny, rho0);
-	force_xy.resize(Nx * Ny * dims, 0.0);
-	force_ibm.resize(Nx * Ny * dims, 0.0);
-	type.resize(Nx * Ny, eFluid);
-	f.resize(Nx * Ny * nVels, 0.0);
-	f_n.resize(Nx * Ny * nVels, 0.0);
+	// Number the sites in the lattice arrays (only non-solid sites are stored with the sparse lattice)
+#ifdef SPARSE
+	buildSparse();
+#else
+	if (ifstream("input/solid.pgm").good())
+		ERROR("Solid mask input/solid.pgm needs the sparse lattice (SPARSE in params.h)...exiting");
+#ifdef MPI_SLABS
+	nSites = (iEnd - iStart + 2) * Ny;
+	idStart = Ny;
+	idEnd = (iEnd - iStart + 1) * Ny;
+#else
+	nSites = Nx * Ny;
+	idStart = iStart * Ny;
+	idEnd = iEnd * Ny;
+#endif
+#endif
+
+	// Set the sizes of the lattice arrays (memory is not touched yet)
+	u.resize(nSites * dims);
+	rho.resize(nSites);
+#ifndef LEAN_MEMORY
+	u_n.resize(nSites * dims);
+	rho_n.resize(nSites);
+	force_xy.resize(nSites * dims);
+#endif
+	force_ibm.resize(nSites * dims);
+	forceMask.resize(nSites);
+	type.resize(nSites);
+#ifdef MOMENTS
+	mom.resize(nSites * nMoms);
+	mom_n.resize(nSites * nMoms);
+#elif !defined SPARSE
+
+	// Get size of population arrays (AoSoA is padded to a whole number of blocks)
+	int nPops = NxPad * NyPad * nVels;
+	if (LAYOUT == eAoSoA)
+		nPops = ((NxPad * NyPad + blockWidth - 1) / blockWidth) * blockWidth * nVels;
+	f.resize(nPops);
+	sidStart = 0;
+	sidEnd = nPops / nVels;
+#ifdef AA_PATTERN
+	aaSwapped = false;
+#else
+	f_n.resize(nPops);
+#endif
+#endif
+
+	// Initialise a lattice site
+	auto initialiseSite = [&](int id) {
+
+		// Initialise macroscopic values
+		for (int d = 0; d < dims; d++) {
+			u[id * dims + d] = 0.0;
+			force_ibm[id * dims + d] = 0.0;
+#ifndef LEAN_MEMORY
+			u_n[id * dims + d] = 0.0;
+			force_xy[id * dims + d] = 0.0;
+#endif
+		}
+		rho[id] = rho0;
+#ifndef LEAN_MEMORY
+		rho_n[id] = rho0;
+#endif
+		type[id] = eFluid;
+		forceMask[id] = 0;
+
+		// Initialise moments
+#ifdef MOMENTS
+		for (int m = 0; m < nMoms; m++) {
+			mom[id * nMoms + m] = 0.0;
+			mom_n[id * nMoms + m] = 0.0;
+		}
+#endif
+	};
+
+	// Initialise populations at a storage site
+#ifndef MOMENTS
+	auto initialisePops = [&](int sid) {
+		for (int v = 0; v < nVels; v++) {
+			f[layoutIdx(sid, v)] = 0.0;
+#ifndef AA_PATTERN
+			f_n[layoutIdx(sid, v)] = 0.0;
+#endif
+		}
+	};
+#endif
+
+	// First touch the lattice arrays with the same static partition as the solver loops (so pages sit with the threads that use them)
+#pragma omp parallel
+	{
+
+		// Loop through all points in the slab
+#pragma omp for schedule(static)
+		for (int id = idStart; id < idEnd; id++)
+			initialiseSite(id);
+
+		// Loop through all storage sites in the slab (including ghost and padding sites)
+#ifndef MOMENTS
+#pragma omp for schedule(static)
+		for (int sid = sidStart; sid < sidEnd; sid++)
+			initialisePops(sid);
+#endif
+	}
+
+	// Initialise the ghost columns either side of the slab (first and last local columns)
+#ifdef MPI_SLABS
+	for (int id = 0; id < Ny; id++) {
+		initialiseSite(id);
+		initialiseSite(idEnd + id);
+	}
+#endif
+
+	// Initialise the site shared by all solid sites (sparse lattice)
+#ifdef SPARSE
+	initialiseSite(idEnd);
+	type[idEnd] = eSolid;
+#endif
+#if defined AA_PATTERN || defined FUSED || defined MOMENTS
+	if (wallRight == eConvective)
+		f_out.resize(Ny * nVels, 0.0);
+#endif
 
 	// Set sizes of helper arrays
 	u_in.resize(Ny * dims, 0.0);
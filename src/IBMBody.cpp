@@ -29,9 +29,12 @@ IBMBodyClass::IBMBodyClass(vector<IBMNodeClass> &iNode) {
 	// Set values (some of them don't matter)
 	oPtr = iNode[0].iPtr->oPtr;
 	ID = 0;
+	rank = 0;
+	level = 0;
 	flex = eFlexible;
 	bodyType = eCircle;
 	sBody = NULL;
+	refresh = true;
 
 	// Reserve space
 	node.reserve(iNode.size());
@@ -47,12 +50,20 @@ IBMBodyClass::IBMBodyClass(ObjectsClass *objects, int bodyID,  const array<doubl
 	// Set body values
 	oPtr = objects;
 	ID = bodyID;
+	rank = 0;
+	level = 0;
 	flex = eRigid;
 	bodyType = eCircle;
 	sBody = NULL;
+	refresh = true;
+
+	// Get the finest level which holds the body
+	array<double, dims> lo = {pos[eX] - radius, pos[eY] - radius};
+	array<double, dims> hi = {pos[eX] + radius, pos[eY] + radius};
+	level = oPtr->gPtr->bodyLevel(lo, hi);
 
 	// Get number of markers
-	int numNodes = static_cast<int>(floor(2.0 * M_PI * radius / oPtr->gPtr->Dx));
+	int numNodes = static_cast<int>(floor(2.0 * M_PI * radius / oPtr->gPtr->levelDx(level)));
 
 	// Position vector for marker
 	array<double, dims> position;
@@ -82,8 +93,11 @@ IBMBodyClass::IBMBodyClass(ObjectsClass *objects, int bodyID, const array<double
 	// Set body values
 	oPtr = objects;
 	ID = bodyID;
+	rank = 0;
+	level = 0;
 	bodyType = eFilament;
 	sBody = NULL;
+	refresh = true;
 
 	// Set flex type
 	if (flexStr == "FLEXIBLE")
@@ -100,8 +114,15 @@ IBMBodyClass::IBMBodyClass(ObjectsClass *objects, int bodyID, const array<double
 	// Get rotation matrix
 	array<array<double, dims>, dims> T = Utils::getRotationMatrix(angle);
 
+	// Get the finest level which holds the body
+	array<double, dims> tip = {length, 0.0};
+	tip = pos + T * tip;
+	array<double, dims> lo = {min(pos[eX], tip[eX]), min(pos[eY], tip[eY])};
+	array<double, dims> hi = {max(pos[eX], tip[eX]), max(pos[eY], tip[eY])};
+	level = oPtr->gPtr->bodyLevel(lo, hi);
+
 	// Build the IBM body
-	int numNodes = static_cast<int>(floor(length / oPtr->gPtr->Dx)) + 1;
+	int numNodes = static_cast<int>(floor(length / oPtr->gPtr->levelDx(level))) + 1;
 
 	// Position vector for marker
 	array<double, dims> position;
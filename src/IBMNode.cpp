@@ -28,6 +28,10 @@ void IBMNodeClass::interpolate() {
 	// Get pointer to grid
 	GridClass *gPtr = iPtr->oPtr->gPtr;
 
+	// Get values on the level the support sits on
+	const double *rhoLev = (level == 0 ? gPtr->rho.data() : gPtr->patch[level - 1].rho.data());
+	const double *uLev = (level == 0 ? gPtr->u.data() : gPtr->patch[level - 1].u.data());
+
 	// Set to zero
 	interpRho = 0.0;
 	fill(interpMom.begin(), interpMom.end(), 0.0);
@@ -36,14 +40,14 @@ void IBMNodeClass::interpolate() {
 	for (size_t s = 0; s < suppCount; s++) {
 
 		// Get ID
-		int id = supp[s].idx * Ny + supp[s].jdx;
+		int id = gPtr->levelSiteIdx(level, supp[s].idx, supp[s].jdx);
 
 		// Interpolate density
-		interpRho += gPtr->rho[id] * supp[s].diracVal * 1.0 * 1.0;
+		interpRho += rhoLev[id] * supp[s].diracVal * 1.0 * 1.0;
 
 		// Interpolate momentum
 		for (int d = 0; d < dims; d++)
-			interpMom[d] += gPtr->rho[id] * gPtr->u[id * dims + d] * supp[s].diracVal * 1.0 * 1.0;
+			interpMom[d] += rhoLev[id] * uLev[id * dims + d] * supp[s].diracVal * 1.0 * 1.0;
 	}
 }
 
@@ -53,44 +57,15 @@ void IBMNodeClass::forceCalc() {
 	// Double get vel scaling
 	double velScale = iPtr->oPtr->gPtr->Dt / iPtr->oPtr->gPtr->Dx;
 
-	// Loop through dimensions (divided by timestep = 1)
-	force = 2.0 * (velScale * interpRho * vel  - interpMom);
+	// Loop through dimensions (divided by timestep = 1, spread over the sub-steps of a refined patch)
+	force = (2.0 / (1 << level)) * (velScale * interpRho * vel  - interpMom);
 }
 
-// Force spread
-void IBMNodeClass::spread() {
-
-	// Get pointer to grid
-	GridClass *gPtr = iPtr->oPtr->gPtr;
-
-	// Loop through support
-	for (size_t s = 0; s < suppCount; s++) {
-
-		// Get ID
-		int id = supp[s].idx * Ny + supp[s].jdx;
-
-		// Get forces
-		double Fx = force[eX] * epsilon * ds * 1.0 * supp[s].diracVal;
-		double Fy = force[eY] * epsilon * ds * 1.0 * supp[s].diracVal;
-
-		// Do either atomic (for performance) or ordered (for repeatability) reduction
-#ifdef ORDERED
-#pragma omp ordered
-		{
-			// Ordered write so is repeatable for different runs
-			gPtr->force_ibm[id * dims + eX] += Fx;
-			gPtr->force_ibm[id * dims + eY] += Fy;
-		}
-#else
-		// Atomic operation for concurrent writes
-#pragma omp atomic update
-		gPtr->force_ibm[id * dims + eX] += Fx;
+// Force spread back to a support point (summed per site by ObjectsClass::ibmKernelSpread)
+double IBMNodeClass::spreadForce(int s, int d) const {
 
-		// Atomic operation for concurrent writes
-#pragma omp atomic update
-		gPtr->force_ibm[id * dims + eY] += Fy;
-#endif
-	}
+	// Get force
+	return force[d] * epsilon * ds * 1.0 * supp[s].diracVal;
 }
 
 // Update macroscopic
@@ -99,8 +74,14 @@ void IBMNodeClass::updateMacroscopic() {
 	// Get pointer to grid
 	GridClass *gPtr = iPtr->oPtr->gPtr;
 
-	// Loop through support points
+	// Get values on the level the support sits on
+	double *rhoLev = (level == 0 ? gPtr->rho.data() : gPtr->patch[level - 1].rho.data());
+	double *uLev = (level == 0 ? gPtr->u.data() : gPtr->patch[level - 1].u.data());
+
+	// Loop through support points (only sites owned by this rank)
 	for (size_t s = 0; s < suppCount; s++) {
+		if (level == 0 && gPtr->ownsColumn(supp[s].idx) == false)
+			continue;
 
 		// Reset temp values
 		double rhoTmp = 0.0;
@@ -108,64 +89,109 @@ void IBMNodeClass::updateMacroscopic() {
 		double vTmp = 0.0;
 
 		// Get ID
-		int id = supp[s].idx * Ny + supp[s].jdx;
+		int id = gPtr->levelSiteIdx(level, supp[s].idx, supp[s].jdx);
 
-		// Sum to find rho and momentum
-		for (int v = 0; v < nVels; v++) {
-			rhoTmp += gPtr->f[id * nVels + v];
-			uTmp += gPtr->c[v * dims + eX] * gPtr->f[id * nVels + v];
-			vTmp += gPtr->c[v * dims + eY] * gPtr->f[id * nVels + v];
+		// Solid sites hold no populations (sparse lattice)
+#ifdef SPARSE
+		if (level == 0 && gPtr->type[id] == eSolid)
+			continue;
+#endif
+
+		// Refined patch
+		if (level > 0) {
+
+			// Sum to find rho and momentum
+			const GridPatch &p = gPtr->patch[level - 1];
+			for (int v = 0; v < nVels; v++) {
+				rhoTmp += p.f[id * nVels + v];
+				uTmp += gPtr->c[v * dims + eX] * p.f[id * nVels + v];
+				vTmp += gPtr->c[v * dims + eY] * p.f[id * nVels + v];
+			}
+
+			// Add forces and divide by rho
+			uTmp = (uTmp + 0.5 * (p.forceXY[eX] + p.force_ibm[id * dims + eX])) / rhoTmp;
+			vTmp = (vTmp + 0.5 * (p.forceXY[eY] + p.force_ibm[id * dims + eY])) / rhoTmp;
 		}
 
-		// Add forces and divide by rho
-		uTmp = (uTmp + 0.5 * (gPtr->force_xy[id * dims + eX] + gPtr->force_ibm[id * dims + eX])) / rhoTmp;
-		vTmp = (vTmp + 0.5 * (gPtr->force_xy[id * dims + eY] + gPtr->force_ibm[id * dims + eY])) / rhoTmp;
+		// Grid
+		else {
+
+			// Sum to find rho and momentum (already stored with moment storage)
+#ifdef MOMENTS
+			rhoTmp = gPtr->mom[id * nMoms + eRho];
+			uTmp = gPtr->mom[id * nMoms + eJx];
+			vTmp = gPtr->mom[id * nMoms + eJy];
+#else
+			for (int v = 0; v < nVels; v++) {
+				rhoTmp += gPtr->getPop(gPtr->f, gPtr->fIdx(id, v), v);
+				uTmp += gPtr->c[v * dims + eX] * gPtr->getPop(gPtr->f, gPtr->fIdx(id, v), v);
+				vTmp += gPtr->c[v * dims + eY] * gPtr->getPop(gPtr->f, gPtr->fIdx(id, v), v);
+			}
+#endif
+
+			// Add forces and divide by rho
+			uTmp = (uTmp + 0.5 * (gPtr->siteForce(id, eX) + gPtr->force_ibm[id * dims + eX])) / rhoTmp;
+			vTmp = (vTmp + 0.5 * (gPtr->siteForce(id, eY) + gPtr->force_ibm[id * dims + eY])) / rhoTmp;
+		}
 
 		// Atomic operation for concurrent writes
 #pragma omp atomic write
-		gPtr->rho[id] = rhoTmp;
+		rhoLev[id] = rhoTmp;
 
 		// Atomic operation for concurrent writes
 #pragma omp atomic write
-		gPtr->u[id * dims + eX] = uTmp;
+		uLev[id * dims + eX] = uTmp;
 
 		// Atomic operation for concurrent writes
 #pragma omp atomic write
-		gPtr->u[id * dims + eY] = vTmp;
+		uLev[id * dims + eY] = vTmp;
 	}
 }
 
-// Find support
+// Find support (around the position support and epsilon are computed at, so every rank holding the marker finds the same sites)
 void IBMNodeClass::findSupport() {
 
+	// Keep the current support sites so changes can be flagged
+	array<IBMSupportClass, suppSize> suppOld = supp;
+	size_t suppCountOld = suppCount;
+	int levelOld = level;
+
 	// Clear the current support points
 	supp.fill(IBMSupportClass(0, 0, 0.0));
 
 	// Stencil width
 	double stencilWidth = 1.5;
 
-	// Get lattice spacing
-	double Dx = iPtr->oPtr->gPtr->Dx;
+	// Get the finest level which holds the marker and its lattice spacing and origin
+	GridClass *gPtr = iPtr->oPtr->gPtr;
+	level = gPtr->markerLevel(posEps);
+	double Dx = gPtr->levelDx(level);
+	array<double, dims> origin = gPtr->levelOrigin(level);
+	int nxLev = gPtr->levelNx(level);
+	int nyLev = gPtr->levelNy(level);
 
 	// Get closest lattice sites to marker
-	int inear = static_cast<int>(round(pos[eX] / Dx));
-	int jnear = static_cast<int>(round(pos[eY] / Dx));
+	int inear = static_cast<int>(round((posEps[eX] - origin[eX]) / Dx));
+	int jnear = static_cast<int>(round((posEps[eY] - origin[eY]) / Dx));
+
+	// Rank which owns the closest column does the interpolation (patches are only used with one rank)
+	rank = (level == 0 ? Utils::blockRank(min(max(inear, 0), Nx - 1), Nx, gPtr->nRanks) : 0);
 
 	// Loop through x
 	suppCount = 0;
 	for (int i = inear - 2; i <= inear + 2; i++) {
 
 		// Get distance in x
-		double distX = fabs(pos[eX] / Dx - i);
+		double distX = fabs((posEps[eX] - origin[eX]) / Dx - i);
 
 		// Loop through y
 		for (int j = jnear - 2; j <= jnear + 2; j++) {
 
 			// Get distance in y
-			double distY = fabs(pos[eY] / Dx - j);
+			double distY = fabs((posEps[eY] - origin[eY]) / Dx - j);
 
 			// Check distance and if it is within grid
-			if (distX < stencilWidth && distY < stencilWidth && i >= 0 && i <= Nx-1 && j >= 0 && j <= Ny-1) {
+			if (distX < stencilWidth && distY < stencilWidth && i >= 0 && i <= nxLev - 1 && j >= 0 && j <= nyLev - 1) {
 
 				// Check if buffer size is big enough
 				if (suppCount == suppSize)
@@ -176,6 +202,13 @@ void IBMNodeClass::findSupport() {
 			}
 		}
 	}
+
+	// Flag if the support sites changed (force spreading list has to be rebuilt)
+	bool changed = (suppCount != suppCountOld || level != levelOld);
+	for (size_t s = 0; s < suppCount && changed == false; s++)
+		changed = (supp[s].idx != suppOld[s].idx || supp[s].jdx != suppOld[s].jdx);
+	if (changed == true)
+		suppChanged = true;
 }
 
 // Compute spacing between IBM nodes
@@ -191,7 +224,7 @@ void IBMNodeClass::computeDs() {
 		if (ID != iPtr->node[n]->ID) {
 
 			// Get distance between nodes
-			double mag = sqrt((pos - iPtr->node[n]->pos) * (pos - iPtr->node[n]->pos)) / iPtr->oPtr->gPtr->Dx;
+			double mag = sqrt((pos - iPtr->node[n]->pos) * (pos - iPtr->node[n]->pos)) / iPtr->oPtr->gPtr->levelDx(level);
 
 			// Check if min found so far
 			if (mag < currentDs)
@@ -211,14 +244,20 @@ IBMNodeClass::IBMNodeClass(IBMBodyClass *iPointer, int nodeID, const array<doubl
 
 	// Set ID
 	ID = nodeID;
+	rank = 0;
 
 	// Set positions
 	pos = position;
+	posEps = position;
+	suppChanged = true;
 
 	// Set velocities and forces to zero
 	vel.fill(0.0);
 	force.fill(0.0);
 
+	// Start on the level of the body (support is found later)
+	level = iPtr->level;
+
 	// These values will be set later
 	ds = 0.0;
 	epsilon = 0.0;
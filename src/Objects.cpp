@@ -22,10 +22,11 @@
 #include "../inc/Grid.h"
 #include "../inc/Utils.h"
 
-// Main kernel for objects
+// Main kernel for objects (run by every thread of the solver team)
 void ObjectsClass::objectKernel() {
 
 	// While loop parameters
+#pragma omp single
 	subIt = 0;
 	int MAXIT = 20;
 
@@ -46,7 +47,8 @@ void ObjectsClass::objectKernel() {
 		// Do FEM step
 		femKernel();
 
-		// Increase subIt
+		// Increase subIt (only one thread)
+#pragma omp single
 		subIt++;
 
 	} while (subIt < MAXIT && subRes > subTol);
@@ -55,6 +57,7 @@ void ObjectsClass::objectKernel() {
 	ibmKernelSpread();
 
 	// If it reached max iterations then exit
+#pragma omp single
 	if (subIt == MAXIT)
 		ERROR("Subiteration scheme hit " + to_string(subIt) + " iterations...exiting");
 }
@@ -62,16 +65,50 @@ void ObjectsClass::objectKernel() {
 // Do FEM and update IBM positions and velocities
 void ObjectsClass::femKernel() {
 
-	// Declare residual parameters
+	// Reset global values (only one thread)
+#pragma omp single
+	{
+		subRes = 0.0;
+		subNum = 0.0;
+		subDen = 0.0;
+	}
+
+	// Do FEM on the bodies this rank owns and sum residuals in body order once they are shared
+#ifdef MPI_SLABS
+
+	// Loop through bodies owned by this rank and do FEM
+#pragma omp for schedule(dynamic,1)
+	for (size_t ib = 0; ib < iBody.size(); ib++) {
+		if (iBody[ib].flex == eFlexible && iBody[ib].rank == gPtr->rank)
+			iBody[ib].sBody->dynamicFEM();
+	}
+
+	// Share body residuals then sum to get global values (new marker positions are sent by the next relaxation, only one thread)
+#pragma omp single
+	{
+		shareResiduals();
+		for (size_t ib = 0; ib < iBody.size(); ib++) {
+			if (iBody[ib].flex == eFlexible) {
+				subRes += iBody[ib].sBody->subRes;
+				subNum += iBody[ib].sBody->subNum;
+				subDen += iBody[ib].sBody->subDen;
+			}
+		}
+	}
+#else
+
+	// Declare residual parameters for this thread
+#ifndef ORDERED
 	double res = 0.0;
 	double num = 0.0;
 	double den = 0.0;
+#endif
 
 	// Loop through all bodies, do FEM, and then sum to get residual values
 #ifdef ORDERED
-	#pragma omp parallel for ordered schedule(dynamic,1)
+	#pragma omp for ordered schedule(dynamic,1)
 #else
-	#pragma omp parallel for schedule(guided) reduction(+:res, num, den)
+	#pragma omp for schedule(guided) nowait
 #endif
 	for (size_t ib = 0; ib < iBody.size(); ib++) {
 		if (iBody[ib].flex == eFlexible) {
@@ -79,245 +116,922 @@ void ObjectsClass::femKernel() {
 			// Do the dynamic FEM routine
 			iBody[ib].sBody->dynamicFEM();
 
-			// Either do ordered or non-deterministic sum (it can affect results)
+			// Either do ordered sum straight into global values or non-deterministic sum (it can affect results)
 #ifdef ORDERED
 		#pragma omp ordered
-#endif
 			{
 				// Sum to get global values
-				res += iBody[ib].sBody->subRes;
-				num += iBody[ib].sBody->subNum;
-				den += iBody[ib].sBody->subDen;
+				subRes += iBody[ib].sBody->subRes;
+				subNum += iBody[ib].sBody->subNum;
+				subDen += iBody[ib].sBody->subDen;
 			}
+#else
+			res += iBody[ib].sBody->subRes;
+			num += iBody[ib].sBody->subNum;
+			den += iBody[ib].sBody->subDen;
+#endif
 		}
 	}
 
-	// Set global values
-	subRes = sqrt(res) / (ref_L * sqrt(static_cast<double>(simDOFs)));
-	subNum = num;
-	subDen = den;
+	// Add this thread's sums to global values
+#ifndef ORDERED
+#pragma omp critical
+	{
+		subRes += res;
+		subNum += num;
+		subDen += den;
+	}
+#pragma omp barrier
+#endif
+#endif
+
+	// Set global residual (only one thread)
+#pragma omp single
+	subRes = sqrt(subRes) / (ref_L * sqrt(static_cast<double>(simDOFs)));
 }
 
 // Interpolate and force calc
 void ObjectsClass::ibmKernelInterp() {
 
-	// Reset IBM forces
-	fill(gPtr->force_ibm.begin(), gPtr->force_ibm.end(), 0.0);
+	// Rigid markers using the assembled operator (fluid is frozen during subiterations so only do it on the first one)
+	if (subIt == 0) {
+#pragma omp for schedule(static) nowait
+		for (size_t r = 0; r < rigidNode.size(); r++) {
+
+			// Get values on the level the support sits on
+			IBMNodeClass &node = iNode[rigidNode[r]];
+			const double *rhoLev = (node.level == 0 ? gPtr->rho.data() : gPtr->patch[node.level - 1].rho.data());
+			const double *uLev = (node.level == 0 ? gPtr->u.data() : gPtr->patch[node.level - 1].u.data());
+
+			// Interpolate density and momentum
+			double rhoSum = 0.0;
+			double momX = 0.0;
+			double momY = 0.0;
+			for (int k = rigidStart[r]; k < rigidStart[r + 1]; k++) {
+				int id = rigidSite[k];
+				rhoSum += rhoLev[id] * rigidWeight[k];
+				momX += rhoLev[id] * uLev[id * dims + eX] * rigidWeight[k];
+				momY += rhoLev[id] * uLev[id * dims + eY] * rigidWeight[k];
+			}
+			node.interpRho = rhoSum;
+			node.interpMom = {momX, momY};
+
+			// Force calculation
+			node.forceCalc();
+		}
+	}
+
+	// Loop through flexible nodes held by this rank (only the ones next to the columns this rank owns)
+#pragma omp for schedule(guided)
+	for (size_t f = 0; f < flexNode.size(); f++) {
+		IBMNodeClass &node = iNode[flexNode[f]];
+		if (node.rank == gPtr->rank) {
 
-	// Loop through all bodies and nodes
-#pragma omp parallel for schedule(guided)
-	for (size_t i = 0; i < iNode.size(); i++) {
+			// Interpolate
+			node.interpolate();
 
-		// Interpolate
-		iNode[i].interpolate();
+			// Force calculation
+			node.forceCalc();
+		}
+	}
 
-		// Force calculation
-		iNode[i].forceCalc();
+	// Send the forces to the other ranks holding the markers (only one thread)
+	if (gPtr->nRanks > 1) {
+#pragma omp single
+		shareForces();
 	}
 }
 
 // Force spread and update macro
 void ObjectsClass::ibmKernelSpread() {
 
-	// Reset IBM forces
-	fill(gPtr->force_ibm.begin(), gPtr->force_ibm.end(), 0.0);
+	// The list of contributions only has to be rebuilt if support sites or held flexible markers changed
+#pragma omp single
+	spreadRebuild = (spreadRebuild || spreadSite.empty());
+#pragma omp for schedule(static)
+	for (size_t f = 0; f < flexNode.size(); f++) {
+		if (iNode[flexNode[f]].suppChanged == true) {
+			iNode[flexNode[f]].suppChanged = false;
+#pragma omp atomic write
+			spreadRebuild = true;
+		}
+	}
 
-	// Start parallel section
-#pragma omp parallel
-	{
+	// Rebuild list of contributions to sites in the columns of this rank or on the refined patches (solid sites of the sparse lattice get none)
+	if (spreadRebuild == true) {
 
-		// Loop through all bodies and nodes
-#ifdef ORDERED
-	#pragma omp for ordered schedule(dynamic,1)
-#else
-	#pragma omp for schedule(guided)
-#endif
-		for (size_t i = 0; i < iNode.size(); i++) {
+		// Reset IBM forces on the sites touched by the last spread
+#pragma omp for schedule(static)
+		for (size_t s = 0; s < gPtr->forceSites.size(); s++) {
+			int id = gPtr->forceSites[s];
+			gPtr->force_ibm[id * dims + eX] = 0.0;
+			gPtr->force_ibm[id * dims + eY] = 0.0;
+			gPtr->forceMask[id] = 0;
+		}
 
-			// Force spread
-			iNode[i].spread();
+		// Same on the refined patches
+		for (size_t l = 0; l < gPtr->patch.size(); l++) {
+			GridPatch &p = gPtr->patch[l];
+#pragma omp for schedule(static)
+			for (size_t s = 0; s < p.forceSites.size(); s++) {
+				int id = p.forceSites[s];
+				p.force_ibm[id * dims + eX] = 0.0;
+				p.force_ibm[id * dims + eY] = 0.0;
+				p.forceMask[id] = 0;
+			}
 		}
 
-		// Loop through all bodies and nodes
-#pragma omp for schedule(guided)
-		for (size_t i = 0; i < iNode.size(); i++) {
+		// Set up a buffer for each thread (only one thread)
+#pragma omp single
+		spreadBuf.resize(omp_get_num_threads());
+
+		// Each thread gets the flexible contributions of a contiguous block of markers in marker order (static schedule hands out blocks in thread order)
+		vector<array<int, 4>> &buf = spreadBuf[omp_get_thread_num()];
+		buf.clear();
+#pragma omp for schedule(static)
+		for (size_t f = 0; f < flexNode.size(); f++) {
+			const IBMNodeClass &node = iNode[flexNode[f]];
+			for (size_t s = 0; s < node.suppCount; s++) {
+				if (node.level == 0 && gPtr->ownsColumn(node.supp[s].idx) == false)
+					continue;
+				int id = gPtr->levelSiteIdx(node.level, node.supp[s].idx, node.supp[s].jdx);
+				if (node.level == 0 && gPtr->type[id] == eSolid)
+					continue;
+				buf.push_back({node.level, id, flexNode[f], static_cast<int>(s)});
+			}
+		}
+
+		// Group each block by site (keeping marker order within each site)
+		stable_sort(buf.begin(), buf.end(), [](const array<int, 4> &a, const array<int, 4> &b) {
+			return (a[0] < b[0] || (a[0] == b[0] && a[1] < b[1]));
+		});
+#pragma omp barrier
+
+		// Merge the blocks and the rigid sites (taking blocks in thread order keeps marker order within each site) and list the sites (only one thread)
+#pragma omp single
+		{
+			spreadList.clear();
+			spreadSite.clear();
+			vector<size_t> pos(spreadBuf.size(), 0);
+			size_t r = 0;
+			const array<int, 2> endKey = {numeric_limits<int>::max(), numeric_limits<int>::max()};
+			while (true) {
+
+				// Get next site
+				array<int, 2> key = (r < rigidSpreadSite.size() ? rigidSpreadSite[r] : endKey);
+				for (size_t t = 0; t < spreadBuf.size(); t++) {
+					if (pos[t] < spreadBuf[t].size())
+						key = min(key, array<int, 2>{spreadBuf[t][pos[t]][0], spreadBuf[t][pos[t]][1]});
+				}
+				if (key == endKey)
+					break;
+
+				// Rigid row for this site
+				int rigidRow = -1;
+				if (r < rigidSpreadSite.size() && rigidSpreadSite[r] == key)
+					rigidRow = static_cast<int>(r++);
+
+				// Flexible contributions to this site
+				int start = static_cast<int>(spreadList.size());
+				for (size_t t = 0; t < spreadBuf.size(); t++) {
+					while (pos[t] < spreadBuf[t].size() && spreadBuf[t][pos[t]][0] == key[0] && spreadBuf[t][pos[t]][1] == key[1])
+						spreadList.push_back(spreadBuf[t][pos[t]++]);
+				}
+				spreadSite.push_back({key[0], key[1], rigidRow, start, static_cast<int>(spreadList.size())});
+			}
+
+			// List the sites
+			gPtr->forceSites.clear();
+			for (size_t l = 0; l < gPtr->patch.size(); l++)
+				gPtr->patch[l].forceSites.clear();
+			for (size_t g = 0; g < spreadSite.size(); g++) {
+				if (spreadSite[g][0] > 0)
+					gPtr->patch[spreadSite[g][0] - 1].forceSites.push_back(spreadSite[g][1]);
+				else
+					gPtr->forceSites.push_back(spreadSite[g][1]);
+			}
+		}
+
+		// Mark the sites
+#pragma omp for schedule(static)
+		for (size_t g = 0; g < spreadSite.size(); g++) {
+			if (spreadSite[g][0] > 0)
+				gPtr->patch[spreadSite[g][0] - 1].forceMask[spreadSite[g][1]] = 1;
+			else
+				gPtr->forceMask[spreadSite[g][1]] = 1;
+		}
+
+		// List is up to date (only one thread)
+#pragma omp single
+		spreadRebuild = false;
+	}
 
-			// Update macroscopic
-			iNode[i].updateMacroscopic();
+	// Spread the forces (each site sums its own contributions in marker order and overwrites the last value, so it is repeatable for any number of threads)
+#pragma omp for schedule(static)
+	for (size_t g = 0; g < spreadSite.size(); g++) {
+
+		// Get force on the level the site sits on
+		int level = spreadSite[g][0];
+		int id = spreadSite[g][1];
+		double *forceLev = (level == 0 ? gPtr->force_ibm.data() : gPtr->patch[level - 1].force_ibm.data());
+
+		// Sum rigid contributions
+		double Fx = 0.0;
+		double Fy = 0.0;
+		int r = spreadSite[g][2];
+		if (r >= 0) {
+			for (int k = rigidSpreadStart[r]; k < rigidSpreadStart[r + 1]; k++) {
+				Fx += rigidSpreadWeight[k] * iNode[rigidSpreadSupp[k][0]].force[eX];
+				Fy += rigidSpreadWeight[k] * iNode[rigidSpreadSupp[k][0]].force[eY];
+			}
+		}
+
+		// Sum flexible contributions
+		for (int k = spreadSite[g][3]; k < spreadSite[g][4]; k++) {
+			Fx += iNode[spreadList[k][2]].spreadForce(spreadList[k][3], eX);
+			Fy += iNode[spreadList[k][2]].spreadForce(spreadList[k][3], eY);
 		}
+		forceLev[id * dims + eX] = Fx;
+		forceLev[id * dims + eY] = Fy;
 	}
+
+	// Loop through the markers held by this rank and update macroscopic
+#pragma omp for schedule(guided) nowait
+	for (size_t r = 0; r < rigidHeld.size(); r++)
+		iNode[rigidHeld[r]].updateMacroscopic();
+#pragma omp for schedule(guided)
+	for (size_t f = 0; f < flexNode.size(); f++)
+		iNode[flexNode[f]].updateMacroscopic();
 }
 
 // Recompute support, ds, and epsilon and subiteration values
 void ObjectsClass::recomputeObjectVals() {
 
-	// Start parallel section
-#pragma omp parallel
-	{
-
-		// Do predictor step if first iteration
-		if (subIt == 0) {
+	// Do predictor step if first iteration
+	if (subIt == 0) {
 
-			// Loop through bodies, set start of time step, and do predictor (if on)
+		// Loop through bodies owned by this rank, set start of time step, and do predictor (if on)
 #pragma omp for schedule(guided)
-			for (size_t ib = 0; ib < iBody.size(); ib++) {
-				if (iBody[ib].flex == eFlexible) {
+		for (size_t ib = 0; ib < iBody.size(); ib++) {
+			if (iBody[ib].flex == eFlexible && iBody[ib].rank == gPtr->rank) {
 
-					// Set the start of timestep values
-					iBody[ib].sBody->resetValues();
+				// Set the start of timestep values
+				iBody[ib].sBody->resetValues();
 
-					// Predictor step
-					iBody[ib].sBody->predictor();
-				}
+				// Predictor step
+				iBody[ib].sBody->predictor();
 			}
 		}
+	}
 
-		// Else calculate new relaxation parameter and do the relaxation
-		else {
+	// Else calculate new relaxation parameter and do the relaxation
+	else {
 
-			// Get relaxation value (only one thread)
+		// Get relaxation value (only one thread)
 #pragma omp single
-			{
-				if (subIt == 1) {
+		{
+			if (subIt == 1) {
 
-					// Use max relax if need be on first iteration
-					relax = static_cast<double>(Utils::sgn(relax) * min(fabs(relax), relaxMax));
-				}
-				else {
+				// Use max relax if need be on first iteration
+				relax = static_cast<double>(Utils::sgn(relax) * min(fabs(relax), relaxMax));
+			}
+			else {
 
-					// Use global residual values to get next relaxation factor
-					relax = -relax * subNum / subDen;
-				}
+				// Use global residual values to get next relaxation factor
+				relax = -relax * subNum / subDen;
 			}
+		}
 
-			// Relax displacements and update IBM
+		// Relax displacements and update IBM (bodies owned by this rank)
 #pragma omp for schedule(guided)
-			for (size_t ib = 0; ib < iBody.size(); ib++) {
-				if (iBody[ib].flex == eFlexible) {
+		for (size_t ib = 0; ib < iBody.size(); ib++) {
+			if (iBody[ib].flex == eFlexible && iBody[ib].rank == gPtr->rank) {
 
-					// Apply relaxation
-					iBody[ib].sBody->U = iBody[ib].sBody->U_km1 + relax * (iBody[ib].sBody->U - iBody[ib].sBody->U_km1);
+				// Apply relaxation
+				iBody[ib].sBody->U = iBody[ib].sBody->U_km1 + relax * (iBody[ib].sBody->U - iBody[ib].sBody->U_km1);
 
-					// Update FEM elements
-					iBody[ib].sBody->updateFEMValues();
+				// Update FEM elements
+				iBody[ib].sBody->updateFEMValues();
 
-					// Update the velocity
-					iBody[ib].sBody->finishNewmark();
+				// Update the velocity
+				iBody[ib].sBody->finishNewmark();
 
-					// Update IBM values
-					iBody[ib].sBody->updateIBMValues();
+				// Update IBM values
+				iBody[ib].sBody->updateIBMValues();
 
-					// Set previous iteration value
-					iBody[ib].sBody->U_km1.swap(iBody[ib].sBody->U);
-				}
+				// Set previous iteration value
+				iBody[ib].sBody->U_km1.swap(iBody[ib].sBody->U);
 			}
 		}
+	}
 
-		// Loop through all bodies and nodes
+	// Flag flexible bodies (owned by this rank) with a marker that has moved far enough since support and epsilon were last computed
+#ifdef LAZY_EPSILON
 #pragma omp for schedule(guided)
-		for (size_t i = 0; i < iNode.size(); i++) {
-			if (iNode[i].iPtr->flex == eFlexible) {
-
-				// Find support
-				iNode[i].findSupport();
-
-				// Compute ds
-				iNode[i].computeDs();
+	for (size_t ib = 0; ib < iBody.size(); ib++) {
+		if (iBody[ib].flex == eFlexible && iBody[ib].rank == gPtr->rank) {
+			double disp = 0.0;
+			for (size_t n = 0; n < iBody[ib].node.size(); n++) {
+				IBMNodeClass *node = iBody[ib].node[n];
+				disp = max(disp, max(fabs(node->pos[eX] - node->posEps[eX]), fabs(node->pos[eY] - node->posEps[eY])) / gPtr->levelDx(node->level));
 			}
+			iBody[ib].refresh = (disp >= LAZY_EPSILON);
 		}
 	}
 
-	// Compute epsilon
-	computeEpsilon();
-}
+	// Universal calculation has to be redone if any body needs it, and then all supports must match (only one thread)
+	if (uniEpsilon == true) {
+#pragma omp single
+		{
+			if (gPtr->nRanks > 1)
+				shareRefresh();
+			uniBody[0].refresh = false;
+			for (size_t ib = 0; ib < iBody.size(); ib++)
+				uniBody[0].refresh = uniBody[0].refresh || (iBody[ib].flex == eFlexible && iBody[ib].refresh);
+			for (size_t ib = 0; ib < iBody.size(); ib++)
+				iBody[ib].refresh = uniBody[0].refresh;
+		}
+	}
+#endif
 
-// Compute epsilon
-void ObjectsClass::computeEpsilon() {
+	// Loop through flexible nodes of the bodies owned by this rank
+#pragma omp for schedule(guided)
+	for (size_t f = 0; f < flexNode.size(); f++) {
+		IBMNodeClass &node = iNode[flexNode[f]];
+		if (node.iPtr->rank == gPtr->rank && node.iPtr->refresh == true) {
 
-	// If universal calculation then need to move all markers into tmp iBody holder
-#ifdef UNI_EPSILON
+			// Find support
+			node.posEps = node.pos;
+			node.findSupport();
 
-	// Temporary iBody for storing all markers in whole simulation
-	vector<IBMBodyClass> iBodyTmp;
+			// Compute ds
+			node.computeDs();
+		}
+	}
 
-	// Call constructor with vector of all iBodies
-	iBodyTmp.emplace_back(iNode);
+	// Send new marker positions to the other ranks holding them (only one thread)
+	if (gPtr->nRanks > 1) {
+#pragma omp single
+		shareFlexMarkers();
+	}
 
-	// Set pointer to stop copying of data
-	vector<IBMBodyClass> *iBodyPtr = &iBodyTmp;
-#else
+	// Compute epsilon
+	computeEpsilon();
+}
 
-	// If separated epsilon then just set pointer to point to existing vector
-	vector<IBMBodyClass> *iBodyPtr = &iBody;
-#endif
+// Compute epsilon (run by every thread of a team)
+void ObjectsClass::computeEpsilon() {
 
-	// Get lattice spacing
-	double Dx = gPtr->Dx;
+	// If universal calculation then use the body holding all markers, otherwise the bodies themselves
+	vector<IBMBodyClass> *iBodyPtr = (uniEpsilon == true ? &uniBody : &iBody);
 
 	// Loop through all bodies and get epsilon
-#pragma omp parallel for schedule(guided)
+#pragma omp for schedule(guided)
 	for (size_t ib = 0; ib < (*iBodyPtr).size(); ib++) {
 
-		// Do if first time step; if not first time step then only do if flexible
-		if(gPtr->t == 0 || (*iBodyPtr)[ib].flex == eFlexible) {
+		// Set body
+		IBMBodyClass &body = (*iBodyPtr)[ib];
+
+		// Do if first time step; if not first time step then only do if flexible and it needs recomputing (bodies owned by this rank)
+		if((gPtr->t == 0 || body.flex == eFlexible) && body.rank == gPtr->rank) {
+
+			// Skip if markers have hardly moved since last time
+			if (gPtr->t > 0 && body.refresh == false) {
+#pragma omp atomic
+				epsSkips++;
+				continue;
+			}
 
 			// Get size of A matrix
-			size_t dim = (*iBodyPtr)[ib].node.size();
+			size_t dim = body.node.size();
+
+			// Bin nodes by level and nearest lattice site (sorted so each column of sites is a contiguous range)
+			body.epsBins.resize(dim);
+			for (size_t j = 0; j < dim; j++) {
+				IBMNodeClass *nodej = body.node[j];
+				double Dx = gPtr->levelDx(nodej->level);
+				array<double, dims> origin = gPtr->levelOrigin(nodej->level);
+				body.epsBins[j] = {nodej->level, static_cast<int>(round((nodej->pos[eX] - origin[eX]) / Dx)), static_cast<int>(round((nodej->pos[eY] - origin[eY]) / Dx)), static_cast<int>(j)};
+			}
+			sort(body.epsBins.begin(), body.epsBins.end());
 
-			// Set A matrix
-			vector<double> A(dim * dim, 0.0);
+			// Set A matrix (CSR)
+			body.epsRowStart.assign(dim + 1, 0);
+			body.epsCol.clear();
+			body.epsVal.clear();
 
 			// Loop through all nodes
 			for (size_t i = 0; i < dim; i++) {
 
 				// Set node i
-				IBMNodeClass *nodei = (*iBodyPtr)[ib].node[i];
+				IBMNodeClass *nodei = body.node[i];
+
+				// Get lattice spacing and origin of the level node i sits on
+				double Dx = gPtr->levelDx(nodei->level);
+				array<double, dims> origin = gPtr->levelOrigin(nodei->level);
+
+				// Get extent of support for node i
+				int iMin = nodei->supp[0].idx, iMax = iMin, jMin = nodei->supp[0].jdx, jMax = jMin;
+				for (size_t s = 1; s < nodei->suppCount; s++) {
+					iMin = min(iMin, nodei->supp[s].idx);
+					iMax = max(iMax, nodei->supp[s].idx);
+					jMin = min(jMin, nodei->supp[s].jdx);
+					jMax = max(jMax, nodei->supp[s].jdx);
+				}
+
+				// Get nodes on the same level whose nearest site is close enough to share support sites
+				body.epsNbrs.clear();
+				for (int cx = iMin - 2; cx <= iMax + 2; cx++) {
+					auto lo = lower_bound(body.epsBins.begin(), body.epsBins.end(), array<int, 4>{nodei->level, cx, jMin - 2, 0});
+					auto hi = lower_bound(lo, body.epsBins.end(), array<int, 4>{nodei->level, cx, jMax + 3, 0});
+					for (auto it = lo; it != hi; ++it)
+						body.epsNbrs.push_back((*it)[3]);
+				}
+				sort(body.epsNbrs.begin(), body.epsNbrs.end());
 
-				// Loop though all nodes again
-				for (size_t j = 0; j < dim; j++) {
+				// Loop though neighbouring nodes
+				for (size_t n = 0; n < body.epsNbrs.size(); n++) {
 
 					// Set node j
-					IBMNodeClass *nodej = (*iBodyPtr)[ib].node[j];
+					IBMNodeClass *nodej = body.node[body.epsNbrs[n]];
 
 					// Now loop through all support markers for node i
+					double Aij = 0.0;
 					for (size_t s = 0; s < nodei->suppCount; s++) {
 
 						// Dirac delta value of support marker for node i and support s
 						double diracVal_i = nodei->supp[s].diracVal;
 
 						// Delta value between node i support s and node j
-						double distX = fabs(nodej->pos[eX] / Dx - nodei->supp[s].idx);
-						double distY = fabs(nodej->pos[eY] / Dx - nodei->supp[s].jdx);
+						double distX = fabs((nodej->pos[eX] - origin[eX]) / Dx - nodei->supp[s].idx);
+						double distY = fabs((nodej->pos[eY] - origin[eY]) / Dx - nodei->supp[s].jdx);
 						double diracVal_j = Utils::diracDelta(distX) * Utils::diracDelta(distY);
 
 						// Add to A matrix
-						A[i * dim + j] += diracVal_i * diracVal_j;
+						Aij += diracVal_i * diracVal_j;
 					}
 
-					// Mulitply by volume
-					A[i * dim + j] *= 1.0 * 1.0 * nodej->ds;
+					// Mulitply by volume and store if the supports overlap
+					Aij *= 1.0 * 1.0 * nodej->ds;
+					if (Aij != 0.0) {
+						body.epsCol.push_back(body.epsNbrs[n]);
+						body.epsVal.push_back(Aij);
+					}
 				}
+				body.epsRowStart[i+1] = static_cast<int>(body.epsCol.size());
 			}
 
-			// Set RHS
-			vector<double> b(dim, 1.0);
+			// Set RHS and initial guess (previous epsilon if lazy)
+			body.epsRHS.assign(dim, 1.0);
+			body.epsilon.resize(dim);
+			for (size_t i = 0; i < dim; i++) {
+#ifdef LAZY_EPSILON
+				body.epsilon[i] = (gPtr->t > 0 ? body.node[i]->epsilon : 1.0);
+#else
+				body.epsilon[i] = 1.0;
+#endif
+			}
 
-			// Solve system
-			vector<double> epsilon = Utils::solveLAPACK(A, b);
+			// Solve system (the best iterate is kept if it is close enough, otherwise the spreading weights would be wrong)
+			int its;
+			double res;
+			bool converged = Utils::solveBiCGSTAB(body.epsRowStart, body.epsCol, body.epsVal, body.epsRHS, body.epsilon, body.epsWork, its, res);
+			if (converged == false && !(res <= sparseFailTol)) {
+				ostringstream resStr;
+				resStr << res;
+				ERROR("Epsilon solve did not converge (relative residual = " + resStr.str() + ")...exiting");
+			}
 
-			// Set to node values
+			// Set to node values (support was found at the same positions)
 			for (size_t i = 0; i < dim; i++)
-				(*iBodyPtr)[ib].node[i]->epsilon = epsilon[i];
+				body.node[i]->epsilon = body.epsilon[i];
+
+			// Add to statistics
+#pragma omp critical
+			{
+				epsSolves++;
+				epsIts += its;
+				epsRes = max(epsRes, res);
+				if (converged == false)
+					epsFails++;
+			}
 		}
 	}
 
-	// If universal calculation then need to feed them back to iBody vector
-#ifdef UNI_EPSILON
+	// Send epsilon to the other ranks holding the markers (only one thread)
+	if (gPtr->nRanks > 1) {
+#pragma omp single
+		shareEpsilon();
+	}
 
-	// Loop through all bodies and nodes
-	for (size_t n = 0; n < iNode.size(); n++)
-		iNode[n].epsilon = (*iBodyPtr)[0].node[n]->epsilon;
-#endif
+	// Universal calculation also changes epsilon of rigid markers
+	if (uniEpsilon == true)
+		updateRigidWeights();
+}
+
+// Assemble interpolation and spreading operator of the rigid markers this rank holds (their support, ds and epsilon are fixed after the first time step)
+void ObjectsClass::buildRigidOperator() {
+
+	// Interpolation rows for the rigid markers this rank interpolates
+	rigidNode.clear();
+	rigidStart.assign(1, 0);
+	rigidSite.clear();
+	rigidWeight.clear();
+	for (size_t r = 0; r < rigidHeld.size(); r++) {
+		const IBMNodeClass &node = iNode[rigidHeld[r]];
+		if (node.rank == gPtr->rank) {
+			rigidNode.push_back(rigidHeld[r]);
+			for (size_t s = 0; s < node.suppCount; s++) {
+				rigidSite.push_back(gPtr->levelSiteIdx(node.level, node.supp[s].idx, node.supp[s].jdx));
+				rigidWeight.push_back(node.supp[s].diracVal);
+			}
+			rigidStart.push_back(static_cast<int>(rigidSite.size()));
+		}
+	}
+
+	// Get spreading contributions to sites in the columns of this rank or on the refined patches (solid sites of the sparse lattice get none)
+	vector<array<int, 4>> list;
+	for (size_t r = 0; r < rigidHeld.size(); r++) {
+		const IBMNodeClass &node = iNode[rigidHeld[r]];
+		for (size_t s = 0; s < node.suppCount; s++) {
+			if (node.level == 0 && gPtr->ownsColumn(node.supp[s].idx) == false)
+				continue;
+			int id = gPtr->levelSiteIdx(node.level, node.supp[s].idx, node.supp[s].jdx);
+			if (node.level == 0 && gPtr->type[id] == eSolid)
+				continue;
+			list.push_back({node.level, id, rigidHeld[r], static_cast<int>(s)});
+		}
+	}
+
+	// Group by site (keeping marker order within each site) to get the transpose
+	stable_sort(list.begin(), list.end(), [](const array<int, 4> &a, const array<int, 4> &b) {
+		return (a[0] < b[0] || (a[0] == b[0] && a[1] < b[1]));
+	});
+	rigidSpreadSite.clear();
+	rigidSpreadStart.clear();
+	rigidSpreadSupp.clear();
+	for (size_t k = 0; k < list.size(); k++) {
+		if (k == 0 || list[k][0] != list[k - 1][0] || list[k][1] != list[k - 1][1]) {
+			rigidSpreadSite.push_back({list[k][0], list[k][1]});
+			rigidSpreadStart.push_back(static_cast<int>(k));
+		}
+		rigidSpreadSupp.push_back({list[k][2], list[k][3]});
+	}
+	rigidSpreadStart.push_back(static_cast<int>(list.size()));
+
+	// Fold epsilon and ds into the weights
+	rigidSpreadWeight.resize(rigidSpreadSupp.size());
+	updateRigidWeights();
+}
+
+// Refold epsilon into rigid spreading weights (run by every thread of a team)
+void ObjectsClass::updateRigidWeights() {
+
+	// Loop through contributions
+#pragma omp for schedule(static)
+	for (size_t k = 0; k < rigidSpreadSupp.size(); k++) {
+		const IBMNodeClass &node = iNode[rigidSpreadSupp[k][0]];
+		rigidSpreadWeight[k] = node.epsilon * node.ds * 1.0 * node.supp[rigidSpreadSupp[k][1]].diracVal;
+	}
+}
+
+// Get IDs of all IBM support sites
+void ObjectsClass::getSupportSites(vector<int> &suppVec) {
+
+	// Clear vector
+	suppVec.clear();
+
+	// Loop through all support points
+	for (size_t n = 0; n < iNode.size(); n++) {
+		for (size_t s = 0; s < iNode[n].suppCount; s++)
+			suppVec.push_back(gPtr->siteIdx(iNode[n].supp[s].idx, iNode[n].supp[s].jdx));
+	}
+}
+
+// Find support and ds of the markers this rank holds at their current positions and list them (the first rank needs every marker for the universal epsilon)
+void ObjectsClass::findHeldMarkers() {
+
+	// Clear lists
+	flexNode.clear();
+	rigidHeld.clear();
+
+	// Loop through all nodes
+	for (size_t n = 0; n < iNode.size(); n++) {
+
+		// Skip markers this rank does not use
+		bool held = holdsMarker(iNode[n], iNode[n].pos);
+		if (held == false && (uniEpsilon == false || gPtr->rank > 0))
+			continue;
+
+		// Find support
+		iNode[n].posEps = iNode[n].pos;
+		iNode[n].findSupport();
+
+		// Compute ds
+		iNode[n].computeDs();
+
+		// Add to list
+		if (held == true && iNode[n].iPtr->flex == eFlexible)
+			flexNode.push_back(static_cast<int>(n));
+		else if (held == true)
+			rigidHeld.push_back(static_cast<int>(n));
+	}
+
+	// Force spreading list has to be rebuilt
+	spreadRebuild = true;
+}
+
+// Get first and last rank whose slab holds support sites of a marker at pos (patches are only used with one rank)
+array<int, 2> ObjectsClass::supportRanks(const array<double, dims> &pos) const {
+
+	// Only one rank
+	if (gPtr->nRanks == 1)
+		return {0, 0};
+
+	// Support is within one column of the closest one
+	int inear = static_cast<int>(round((pos[eX] - gPtr->levelOrigin(0)[eX]) / gPtr->Dx));
+	int iMin = min(max(inear - 1, 0), Nx - 1);
+	int iMax = min(max(inear + 1, 0), Nx - 1);
+	return {Utils::blockRank(iMin, Nx, gPtr->nRanks), Utils::blockRank(iMax, Nx, gPtr->nRanks)};
+}
+
+// Check if this rank holds a marker at pos (its support touches the slab or this rank owns the body)
+bool ObjectsClass::holdsMarker(const IBMNodeClass &node, const array<double, dims> &pos) const {
+
+	// Get ranks spanned by the support
+	array<int, 2> ranks = supportRanks(pos);
+	return (node.iPtr->rank == gPtr->rank || (gPtr->rank >= ranks[0] && gPtr->rank <= ranks[1]));
+}
+
+// Get ranks holding a marker (at the position its support was found at)
+void ObjectsClass::markerRanks(const IBMNodeClass &node, vector<int> &ranks) const {
+
+	// Ranks spanned by the support then the rank owning the body
+	array<int, 2> supp = supportRanks(node.posEps);
+	ranks.clear();
+	for (int r = supp[0]; r <= supp[1]; r++)
+		ranks.push_back(r);
+	if (node.iPtr->rank < supp[0] || node.iPtr->rank > supp[1])
+		ranks.push_back(node.iPtr->rank);
+}
+
+// Send marker forces from the ranks that interpolated them to the ranks holding the markers
+void ObjectsClass::shareForces() {
+
+	// Pack forces of the markers this rank interpolated (forces of rigid markers only change on the first subiteration)
+	vector<vector<double>> sendBuf(gPtr->nRanks), recvBuf;
+	vector<int> ranks;
+	auto pack = [&](const IBMNodeClass &node) {
+		markerRanks(node, ranks);
+		for (size_t r = 0; r < ranks.size(); r++) {
+			if (ranks[r] != gPtr->rank)
+				sendBuf[ranks[r]].insert(sendBuf[ranks[r]].end(), {static_cast<double>(node.ID), node.force[eX], node.force[eY]});
+		}
+	};
+	if (subIt == 0) {
+		for (size_t r = 0; r < rigidNode.size(); r++)
+			pack(iNode[rigidNode[r]]);
+	}
+	for (size_t f = 0; f < flexNode.size(); f++) {
+		if (iNode[flexNode[f]].rank == gPtr->rank)
+			pack(iNode[flexNode[f]]);
+	}
+
+	// Send to the ranks holding them
+	Utils::exchange(sendBuf, recvBuf);
+
+	// Unpack
+	for (size_t r = 0; r < recvBuf.size(); r++) {
+		for (size_t k = 0; k < recvBuf[r].size(); k += 1 + dims) {
+			IBMNodeClass &node = iNode[static_cast<int>(recvBuf[r][k])];
+			node.force = {recvBuf[r][k + 1], recvBuf[r][k + 2]};
+		}
+	}
+}
+
+// Send flexible markers from the ranks doing their FEM to the ranks holding them (and the first rank for the universal epsilon)
+void ObjectsClass::shareFlexMarkers() {
+
+	// Pack positions, velocities, positions support was found at and ds of the markers of the bodies this rank owns
+	vector<vector<double>> sendBuf(gPtr->nRanks), recvBuf;
+	vector<int> ranks;
+	vector<int> held;
+	for (size_t ib = 0; ib < iBody.size(); ib++) {
+		if (iBody[ib].flex == eFlexible && iBody[ib].rank == gPtr->rank) {
+			for (size_t n = 0; n < iBody[ib].node.size(); n++) {
+				const IBMNodeClass &node = *iBody[ib].node[n];
+				held.push_back(node.ID);
+				markerRanks(node, ranks);
+				if (uniEpsilon == true && find(ranks.begin(), ranks.end(), 0) == ranks.end())
+					ranks.push_back(0);
+				for (size_t r = 0; r < ranks.size(); r++) {
+					if (ranks[r] != gPtr->rank)
+						sendBuf[ranks[r]].insert(sendBuf[ranks[r]].end(), {static_cast<double>(node.ID), node.pos[eX], node.pos[eY], node.vel[eX], node.vel[eY], node.posEps[eX], node.posEps[eY], node.ds});
+				}
+			}
+		}
+	}
+
+	// Send to the ranks holding them
+	Utils::exchange(sendBuf, recvBuf);
+
+	// Unpack (support is only found again if it moved or it was never found on this rank)
+	for (size_t r = 0; r < recvBuf.size(); r++) {
+		for (size_t k = 0; k < recvBuf[r].size(); k += 1 + 3 * dims + 1) {
+			IBMNodeClass &node = iNode[static_cast<int>(recvBuf[r][k])];
+			node.pos = {recvBuf[r][k + 1], recvBuf[r][k + 2]};
+			node.vel = {recvBuf[r][k + 3], recvBuf[r][k + 4]};
+			array<double, dims> posEps = {recvBuf[r][k + 5], recvBuf[r][k + 6]};
+			node.ds = recvBuf[r][k + 7];
+			if (posEps != node.posEps || node.suppCount == 0) {
+				node.posEps = posEps;
+				node.findSupport();
+			}
+			if (holdsMarker(node, node.posEps) == true)
+				held.push_back(node.ID);
+		}
+	}
+
+	// List the held markers in marker order (spreading list has to be rebuilt if they changed)
+	sort(held.begin(), held.end());
+	if (held != flexNode) {
+		flexNode.swap(held);
+		spreadRebuild = true;
+	}
+}
+
+// Send epsilon from the ranks that computed it to the ranks holding the markers (rigid markers only if it was computed this time)
+void ObjectsClass::shareEpsilon() {
+
+	// Get the bodies epsilon is computed on
+	vector<IBMBodyClass> *iBodyPtr = (uniEpsilon == true ? &uniBody : &iBody);
+
+	// Pack epsilon of the markers of the bodies this rank computes
+	vector<vector<double>> sendBuf(gPtr->nRanks), recvBuf;
+	vector<int> ranks;
+	for (size_t ib = 0; ib < (*iBodyPtr).size(); ib++) {
+		const IBMBodyClass &body = (*iBodyPtr)[ib];
+		if (body.rank == gPtr->rank) {
+			bool solved = ((gPtr->t == 0 || body.flex == eFlexible) && (gPtr->t == 0 || body.refresh == true));
+			for (size_t n = 0; n < body.node.size(); n++) {
+				const IBMNodeClass &node = *body.node[n];
+				if (node.iPtr->flex == eFlexible || solved == true) {
+					markerRanks(node, ranks);
+					for (size_t r = 0; r < ranks.size(); r++) {
+						if (ranks[r] != gPtr->rank)
+							sendBuf[ranks[r]].insert(sendBuf[ranks[r]].end(), {static_cast<double>(node.ID), node.epsilon});
+					}
+				}
+			}
+		}
+	}
+
+	// Send to the ranks holding them
+	Utils::exchange(sendBuf, recvBuf);
+
+	// Unpack
+	for (size_t r = 0; r < recvBuf.size(); r++) {
+		for (size_t k = 0; k < recvBuf[r].size(); k += 2)
+			iNode[static_cast<int>(recvBuf[r][k])].epsilon = recvBuf[r][k + 1];
+	}
+}
+
+// Share refresh flags of flexible bodies from the ranks doing their FEM
+void ObjectsClass::shareRefresh() {
+
+	// Pack flags
+	vector<double> vals;
+	vector<int> owner;
+	for (size_t ib = 0; ib < iBody.size(); ib++) {
+		if (iBody[ib].flex == eFlexible) {
+			vals.push_back(iBody[ib].refresh == true ? 1.0 : 0.0);
+			owner.push_back(iBody[ib].rank);
+		}
+	}
+
+	// Share between ranks
+	Utils::shareOwned(vals, 1, owner);
+
+	// Unpack
+	int idx = 0;
+	for (size_t ib = 0; ib < iBody.size(); ib++) {
+		if (iBody[ib].flex == eFlexible)
+			iBody[ib].refresh = (vals[idx++] != 0.0);
+	}
+}
+
+// Share body residuals from the ranks doing their FEM
+void ObjectsClass::shareResiduals() {
+
+	// Pack residual values
+	vector<double> vals;
+	vector<int> owner;
+	for (size_t ib = 0; ib < iBody.size(); ib++) {
+		if (iBody[ib].flex == eFlexible) {
+			vals.push_back(iBody[ib].sBody->subRes);
+			vals.push_back(iBody[ib].sBody->subNum);
+			vals.push_back(iBody[ib].sBody->subDen);
+			owner.push_back(iBody[ib].rank);
+		}
+	}
+
+	// Share between ranks
+	Utils::shareOwned(vals, 3, owner);
+
+	// Unpack
+	int idx = 0;
+	for (size_t ib = 0; ib < iBody.size(); ib++) {
+		if (iBody[ib].flex == eFlexible) {
+			iBody[ib].sBody->subRes = vals[idx++];
+			iBody[ib].sBody->subNum = vals[idx++];
+			iBody[ib].sBody->subDen = vals[idx++];
+		}
+	}
+}
+
+// Get FEM state of each body and its markers from the rank that owns it (for output)
+void ObjectsClass::syncBodies() {
+
+	// Only needed for bodies split over ranks
+	if (hasIBM == false || gPtr->nRanks == 1)
+		return;
+
+	// Pack the markers of the bodies this rank owns
+	vector<vector<double>> sendBuf(gPtr->nRanks), recvBuf;
+	if (gPtr->rank > 0) {
+		for (size_t ib = 0; ib < iBody.size(); ib++) {
+			if (iBody[ib].rank == gPtr->rank) {
+				for (size_t n = 0; n < iBody[ib].node.size(); n++) {
+					const IBMNodeClass &node = *iBody[ib].node[n];
+					sendBuf[0].insert(sendBuf[0].end(), {static_cast<double>(node.ID), node.pos[eX], node.pos[eY], node.vel[eX], node.vel[eY], node.force[eX], node.force[eY], node.ds, node.epsilon});
+				}
+			}
+		}
+	}
+
+	// Gather them on the first rank (which writes the output)
+	Utils::exchange(sendBuf, recvBuf);
+	for (size_t r = 0; r < recvBuf.size(); r++) {
+		for (size_t k = 0; k < recvBuf[r].size(); k += 1 + 3 * dims + 2) {
+			IBMNodeClass &node = iNode[static_cast<int>(recvBuf[r][k])];
+			node.pos = {recvBuf[r][k + 1], recvBuf[r][k + 2]};
+			node.vel = {recvBuf[r][k + 3], recvBuf[r][k + 4]};
+			node.force = {recvBuf[r][k + 5], recvBuf[r][k + 6]};
+			node.ds = recvBuf[r][k + 7];
+			node.epsilon = recvBuf[r][k + 8];
+		}
+	}
+
+	// Loop through flexible bodies
+	for (size_t ib = 0; ib < iBody.size(); ib++) {
+		if (iBody[ib].flex == eFlexible) {
+
+			// Get body and if this rank owns it
+			FEMBodyClass *sBody = iBody[ib].sBody;
+			bool owner = (iBody[ib].rank == gPtr->rank);
+
+			// Copy a value into the buffer (owner) or back out of it (other ranks)
+			vector<double> state;
+			size_t idx = 0;
+			auto sync = [&](double &val) {
+				if (owner == true)
+					state.push_back(val);
+				else
+					val = state[idx++];
+			};
+
+			// Copy everything the outputs and restart files use
+			auto syncState = [&]() {
+				double itNR = sBody->itNR;
+				sync(itNR);
+				sBody->itNR = static_cast<int>(itNR);
+				sync(sBody->resNR);
+				for (vector<double> *vec : {&sBody->U, &sBody->Udot, &sBody->Udotdot, &sBody->U_n, &sBody->U_nm1, &sBody->R_k}) {
+					for (size_t i = 0; i < vec->size(); i++)
+						sync((*vec)[i]);
+				}
+				for (size_t el = 0; el < sBody->element.size(); el++) {
+					sync(sBody->element[el].L);
+					sync(sBody->element[el].angle);
+				}
+				for (size_t n = 0; n < sBody->node.size(); n++) {
+					for (int d = 0; d < dims; d++) {
+						sync(sBody->node[n].pos0[d]);
+						sync(sBody->node[n].pos[d]);
+					}
+					sync(sBody->node[n].angle0);
+					sync(sBody->node[n].angle);
+				}
+			};
+
+			// Pack, broadcast from owner, then unpack
+			if (owner == true)
+				syncState();
+			Utils::broadcast(state, iBody[ib].rank);
+			if (owner == false)
+				syncState();
+		}
+	}
 }
 
 // Read in geometry file
@@ -355,17 +1069,29 @@ void ObjectsClass::geometryReadIn() {
 	// Type of case (the first entry on each line is the keyword describing the body case)
 	string bodyCase;
 
-	// Do a quick scan to see how many bodies there are for reserving memory
+	// Do a quick scan to see how many bodies there are for reserving memory (and get the box around them for refinement)
 	int bodyCount = 0, nodeCount = 0;
+	int refineLevels = 0;
+	double refineMargin = 0.0;
+	array<double, dims> lo = {numeric_limits<double>::max(), numeric_limits<double>::max()};
+	array<double, dims> hi = {numeric_limits<double>::lowest(), numeric_limits<double>::lowest()};
 	while (file >> bodyCase) {
 
+		// ** REFINE ** //
+		if (bodyCase == "REFINE") {
+			file >> refineLevels;
+			file >> refineMargin;
+			file.ignore(numeric_limits<streamsize>::max(), '\n');
+			continue;
+		}
+
 		// Get number of bodies
 		int nBodies; file >> nBodies;
 
-		// Fast forward to dimensions of body
-		string dummy;
-		for (int i = 0; i < 5; i++)
-			file >> dummy;
+		// Read in position of first body and spacing
+		int dummyID; file >> dummyID;
+		array<double, dims> start; file >> start[eX]; file >> start[eY];
+		array<double, dims> space; file >> space[eX]; file >> space[eY];
 
 		// Read in specific values
 		double dim; file >> dim;
@@ -374,17 +1100,44 @@ void ObjectsClass::geometryReadIn() {
 		if (bodyCase == "CIRCLE") {
 			bodyCount += nBodies;
 			nodeCount += nBodies * static_cast<int>(floor(2.0 * M_PI * dim / gPtr->Dx));
+
+			// Grow box around the circles
+			for (int i = 0; i < nBodies; i++) {
+				for (int d = 0; d < dims; d++) {
+					lo[d] = min(lo[d], start[d] + i * space[d] - dim);
+					hi[d] = max(hi[d], start[d] + i * space[d] + dim);
+				}
+			}
 		}
 		// ** FILAMENT ** //
 		else if (bodyCase == "FILAMENT") {
 			bodyCount += nBodies;
 			nodeCount += nBodies * (static_cast<int>(floor(dim / gPtr->Dx)) + 1);
+
+			// Grow box around the filaments (from the start point to the tip)
+			double height; file >> height;
+			double angle; file >> angle;
+			array<double, dims> tip = {dim * cos(angle * M_PI / 180.0), dim * sin(angle * M_PI / 180.0)};
+			for (int i = 0; i < nBodies; i++) {
+				for (int d = 0; d < dims; d++) {
+					lo[d] = min(lo[d], start[d] + i * space[d] + min(0.0, tip[d]));
+					hi[d] = max(hi[d], start[d] + i * space[d] + max(0.0, tip[d]));
+				}
+			}
 		}
 
 		// Skip to end of line
 		file.ignore(numeric_limits<streamsize>::max(), '\n');
 	}
 
+	// Build refined patches around the bodies (markers get twice as close on each level, plus one for rounding)
+	if (refineLevels > 0) {
+		if (bodyCount == 0)
+			ERROR("REFINE needs at least one body in geometry.config...exiting");
+		gPtr->refineAround(lo, hi, refineLevels, refineMargin);
+		nodeCount = (nodeCount + bodyCount) * (1 << refineLevels);
+	}
+
 	// Reserve the space in iBody
 	iBody.reserve(bodyCount);
 	iNode.reserve(nodeCount);
@@ -401,6 +1154,13 @@ void ObjectsClass::geometryReadIn() {
 		// Get type of body
 		file >> bodyCase;
 
+		// Refinement was set up in the scan
+		if (bodyCase == "REFINE") {
+			file.ignore(numeric_limits<streamsize>::max(), '\n');
+			bodyCase = "NONE";
+			continue;
+		}
+
 		// Read in general values first
 		int number; file >> number;
 		int ID; file >> ID;
@@ -520,10 +1280,10 @@ void ObjectsClass::writeTotalForces() {
 		// Force vector
 		array<double, dims> force = {0.0};
 
-		// Get total force
+		// Get total force (markers on a refined patch use its mass and time scalings)
 		for (size_t n = 0; n < iNode.size(); n++) {
 			for (int d = 0; d < dims; d++) {
-				force[d] -= iNode[n].force[d] * 1.0 * iNode[n].epsilon * iNode[n].ds * forceScale;
+				force[d] -= iNode[n].force[d] * 1.0 * iNode[n].epsilon * iNode[n].ds * forceScale / (1 << iNode[n].level);
 			}
 		}
 
@@ -645,6 +1405,14 @@ void ObjectsClass::writeInfo() {
 
 		// Write out average values
 		cout << "FEM taking " << aveIt << " iterations to reach a residual of " << aveRes << " on average" << endl;
+
+		// Write out epsilon solves and reset the statistics
+		cout << "Epsilon taking " << (epsSolves > 0 ? epsIts / epsSolves : 0) << " iterations on average to reach a residual of " << epsRes << " at most (" << epsSolves << " solves, " << epsFails << " not converged, " << epsSkips << " skipped)" << endl;
+		epsSolves = 0;
+		epsFails = 0;
+		epsSkips = 0;
+		epsIts = 0;
+		epsRes = 0.0;
 		cout << setprecision(2) << "Average tip deflection = " << 100.0 * aveDisp << " (% of L)";
 	}
 }
@@ -856,10 +1624,8 @@ void ObjectsClass::writeVTK(bool writeIBM) {
 		output.close();
 
 		// If FEM writing on then write
-#ifdef VTK_FEM
-		if(writeIBM)
+		if (vtkFEMOutput == true && writeIBM)
 			writeVTK(false);
-#endif
 	}
 }
 
@@ -876,7 +1642,7 @@ void ObjectsClass::removeOverlapMarkers() {
 		for (size_t n2 = n1 + 1; n2 < iNode.size(); n2++) {
 
 			// Get distance between nodes
-			double mag = sqrt((iNode[n1].pos - iNode[n2].pos) * (iNode[n1].pos - iNode[n2].pos)) / gPtr->Dx;
+			double mag = sqrt((iNode[n1].pos - iNode[n2].pos) * (iNode[n1].pos - iNode[n2].pos)) / gPtr->levelDx(max(iNode[n1].level, iNode[n2].level));
 
 			// If distance is smaller than 0.5Dx then delete
 			if (mag < 0.5) {
@@ -941,23 +1707,22 @@ void ObjectsClass::removeOverlapMarkers() {
 void ObjectsClass::initialiseObjects() {
 
 	// Call static FEM to give it an initial deflection
-#ifdef INITIAL_DEFLECT
-	if (hasFlex == true)
+	if (initialDeflection != 0.0 && hasFlex == true)
 		initialDeflect();
-#endif
-
-	// Loop through all nodes
-	for (size_t n = 0; n < iNode.size(); n++) {
 
-		// Find support
-		iNode[n].findSupport();
+	// Find support and ds of the markers this rank holds
+	findHeldMarkers();
 
-		// Compute ds
-		iNode[n].computeDs();
-	}
+	// If universal calculation then set up the body holding all markers
+	if (uniEpsilon == true)
+		uniBody.emplace_back(iNode);
 
 	// Compute epsilon
+#pragma omp parallel
 	computeEpsilon();
+
+	// Assemble rigid marker operator
+	buildRigidOperator();
 }
 
 // Call static FEM to give initial deflection
@@ -1170,19 +1935,15 @@ void ObjectsClass::readRestart() {
 		}
 	}
 
-	// Loop through all nodes
-	for (size_t n = 0; n < iNode.size(); n++) {
-
-		// Find support
-		iNode[n].findSupport();
-
-		// Compute ds
-		iNode[n].computeDs();
-	}
+	// Find support and ds of the markers this rank holds
+	findHeldMarkers();
 
-	// Compute epsilon
-	if (hasIBM)
+	// Compute epsilon and reassemble rigid marker operator
+	if (hasIBM) {
+#pragma omp parallel
 		computeEpsilon();
+		buildRigidOperator();
+	}
 
 	// If flexible then recalculate FEM values too
 	for (size_t ib = 0; ib < iBody.size(); ib++) {
@@ -1198,8 +1959,9 @@ void ObjectsClass::readRestart() {
 		}
 	}
 
-	// Clean up files from previous runs
-	restartCleanup();
+	// Clean up files from previous runs (only one rank)
+	if (gPtr->rank == 0)
+		restartCleanup();
 }
 
 // Write out restart file
@@ -1443,15 +2205,15 @@ void ObjectsClass::fillEmptyVTK() {
 						writeEmptyVTK(fname);
 
 					// If writing FEM we need to do the same for them as well
-#ifdef VTK_FEM
+					if (vtkFEMOutput == true) {
 
-					// Create fname string
-					fname = path + "/FEM." + tStep + exStrBody;
+						// Create fname string
+						fname = path + "/FEM." + tStep + exStrBody;
 
-					// Check if file exists
-					if (!boost::filesystem::exists(fname) && hasFlex == true)
-						writeEmptyVTK(fname);
-#endif
+						// Check if file exists
+						if (!boost::filesystem::exists(fname) && hasFlex == true)
+							writeEmptyVTK(fname);
+					}
 				}
 			}
 		}
@@ -1602,6 +2364,13 @@ ObjectsClass::ObjectsClass(GridClass &g) {
 	subNum = 0.0;
 	subDen = 0.0;
 
+	// Epsilon solve statistics
+	epsSolves = 0;
+	epsFails = 0;
+	epsSkips = 0;
+	epsIts = 0;
+	epsRes = 0.0;
+
 	// Set flag to false initially
 	hasIBM = false;
 	hasFlex = false;
@@ -1609,6 +2378,18 @@ ObjectsClass::ObjectsClass(GridClass &g) {
 	// Read in geometry file
 	geometryReadIn();
 
+	// Split flexible bodies (then rigid bodies) into contiguous blocks over the ranks
+	int nFlexBodies = 0;
+	for (size_t ib = 0; ib < iBody.size(); ib++)
+		nFlexBodies += (iBody[ib].flex == eFlexible ? 1 : 0);
+	int flexCount = 0, rigidCount = 0;
+	for (size_t ib = 0; ib < iBody.size(); ib++) {
+		if (iBody[ib].flex == eFlexible)
+			iBody[ib].rank = Utils::blockRank(flexCount++, nFlexBodies, gPtr->nRanks);
+		else
+			iBody[ib].rank = Utils::blockRank(rigidCount++, static_cast<int>(iBody.size()) - nFlexBodies, gPtr->nRanks);
+	}
+
 	// Initialise objects
 	if (hasIBM)
 		initialiseObjects();
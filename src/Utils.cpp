@@ -63,10 +63,10 @@ bool Utils::createDirectories() {
 		ERROR("Problem creating results directory...exiting");
 
 	// Create VTK directory
-#ifdef VTK
-	if (!boost::filesystem::create_directory("Results/VTK"))
-		ERROR("Problem creating vtk directory...exiting");
-#endif
+	if (vtkOutput == true) {
+		if (!boost::filesystem::create_directory("Results/VTK"))
+			ERROR("Problem creating vtk directory...exiting");
+	}
 
 	// Only create restart directory if we need to
 	if (tRestart > 0) {
@@ -93,8 +93,12 @@ void Utils::readRestart(GridClass &grid) {
 	// Read bodies restart data
 	grid.oPtr->readRestart();
 
-	// Delete VTK files that were written after last restart written
-	Utils::deleteVTKs(grid);
+	// Delete VTK files that were written after last restart written (only one rank)
+	if (grid.rank == 0)
+		Utils::deleteVTKs(grid);
+
+	// Wait for the files to be cleaned up
+	Utils::barrier();
 
 	// Write out header
 	cout << "finished";
@@ -109,8 +113,12 @@ void Utils::writeRestart(GridClass &grid) {
 	// Write grid info
 	grid.writeRestart();
 
-	// Write IBM info
-	grid.oPtr->writeRestart();
+	// Get the FEM state from the ranks that own the bodies
+	grid.oPtr->syncBodies();
+
+	// Write IBM info (only one rank)
+	if (grid.rank == 0)
+		grid.oPtr->writeRestart();
 
 	// Write header
 	cout << "finished";
@@ -122,23 +130,28 @@ void Utils::writeInfo(GridClass &grid) {
 	// Write grid info
 	grid.writeInfo();
 
+	// Get the FEM state from the ranks that own the bodies
+	grid.oPtr->syncBodies();
+
 	// Write IBM info
 	grid.oPtr->writeInfo();
 
-	// Write out forces on bodies
-#ifdef FORCES
-	grid.oPtr->writeTotalForces();
-#endif
+	// Write out forces on bodies (only one rank)
+	if (forcesOutput == true && grid.rank == 0)
+		grid.oPtr->writeTotalForces();
 
-	// Write out forces on bodies
-#ifdef TIPS
-	grid.oPtr->writeTips();
-#endif
+	// Write out forces on bodies (only one rank)
+	if (tipsOutput == true && grid.rank == 0)
+		grid.oPtr->writeTips();
 }
 
 // Write log
 void Utils::writeLog(GridClass &grid) {
 
+	// Only one rank writes the log
+	if (grid.rank > 0)
+		return;
+
 	// Write grid info
 	grid.writeLog();
 
@@ -149,8 +162,9 @@ void Utils::writeLog(GridClass &grid) {
 // Write VTK
 void Utils::writeVTK(GridClass &grid) {
 
-	// Write VTK
-#ifdef VTK
+	// Only write if VTK output is on
+	if (vtkOutput == false)
+		return;
 
 	// Write header
 	cout << endl << "Writing VTK data...";
@@ -158,12 +172,15 @@ void Utils::writeVTK(GridClass &grid) {
 	// Write grid VTK
 	grid.writeVTK();
 
-	// Write IBM VTK
-	grid.oPtr->writeVTK();
+	// Get the FEM state from the ranks that own the bodies
+	grid.oPtr->syncBodies();
+
+	// Write IBM VTK (only one rank)
+	if (grid.rank == 0)
+		grid.oPtr->writeVTK();
 
 	// Write header
 	cout << "finished";
-#endif
 }
 
 // Delete future VTKs
@@ -175,8 +192,8 @@ void Utils::deleteVTKs(GridClass &grid) {
 	// Check if it exists
 	if (boost::filesystem::exists(path)) {
 
-		// Loop through three different file types
-		for (int i = 0; i < 3; i++) {
+		// Loop through four different file types
+		for (int i = 0; i < 4; i++) {
 
 			// File strings
 			string fileStr, extStr;
@@ -194,6 +211,10 @@ void Utils::deleteVTKs(GridClass &grid) {
 				fileStr = "FEM";
 				extStr = ".vtp";
 			}
+			else if (i == 3) {
+				fileStr = "Patch";
+				extStr = ".vti";
+			}
 
 			// Get directory iterator
 			boost::filesystem::directory_iterator endit;
@@ -207,8 +228,8 @@ void Utils::deleteVTKs(GridClass &grid) {
 				// Check to make sure it is the files we want
 				if (fStr.find(fileStr) != string::npos && it->path().extension() == extStr) {
 
-					// Get time step
-					string tStepStr = fStr.substr(fileStr.size() + 1, fStr.size());
+					// Get time step (after the level number for patches)
+					string tStepStr = fStr.substr(fStr.find('.') + 1);
 
 					// Convert to int
 					int tStep = stoi(tStepStr);
@@ -238,6 +259,180 @@ int Utils::omp_thread_count() {
 	return n;
 }
 
+// Pin each omp thread to its own core (spread evenly over the cores available to the process)
+void Utils::pinThreads() {
+
+	// Get cores available to the process
+	cpu_set_t procSet;
+	CPU_ZERO(&procSet);
+	if (sched_getaffinity(0, sizeof(cpu_set_t), &procSet) != 0)
+		ERROR("Could not get the cores available for pinning threads...exiting");
+
+	// Put them in a list
+	vector<int> cores;
+	for (int core = 0; core < CPU_SETSIZE; core++) {
+		if (CPU_ISSET(core, &procSet))
+			cores.push_back(core);
+	}
+
+	// Flag to check pinning worked
+	bool pinned = true;
+
+	// Start parallel section
+#pragma omp parallel
+	{
+
+		// Get core for this thread
+		int nThreads = omp_get_num_threads();
+		int core = cores[(static_cast<size_t>(omp_get_thread_num()) * cores.size()) / nThreads];
+
+		// Pin the calling thread to it
+		cpu_set_t threadSet;
+		CPU_ZERO(&threadSet);
+		CPU_SET(core, &threadSet);
+		if (sched_setaffinity(0, sizeof(cpu_set_t), &threadSet) != 0) {
+#pragma omp atomic write
+			pinned = false;
+		}
+	}
+
+	// Check
+	if (pinned == false)
+		ERROR("Could not pin threads to cores...exiting");
+}
+
+// Get list of cores the omp threads are running on
+string Utils::getThreadCores() {
+
+	// Core of each thread
+	vector<int> cores(omp_thread_count(), -1);
+
+	// Get the core each thread is on
+#pragma omp parallel
+	cores[omp_get_thread_num()] = sched_getcpu();
+
+	// Make string
+	string coreString;
+	for (size_t n = 0; n < cores.size(); n++)
+		coreString += (n == 0 ? "" : " ") + to_string(cores[n]);
+
+	// Return
+	return coreString;
+}
+
+// Allocate memory for a lattice array (cache line aligned, large arrays get their own mapping aligned to huge pages)
+void *Utils::latticeAlloc(size_t bytes) {
+
+	// Small arrays are only aligned to cache lines
+	if (bytes < hugePageSize) {
+		void *ptr = NULL;
+		if (posix_memalign(&ptr, cacheLine, max(bytes, cacheLine)) != 0)
+			throw bad_alloc();
+		return ptr;
+	}
+
+	// Round up to whole huge pages
+	size_t mapBytes = ((bytes + hugePageSize - 1) / hugePageSize) * hugePageSize;
+	void *ptr = MAP_FAILED;
+
+	// Try explicit huge pages first (only succeeds if enough are reserved)
+#ifdef HUGE_PAGES
+	ptr = mmap(NULL, mapBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+
+	// Otherwise map normal pages starting on a huge page boundary (so the kernel can back them with transparent huge pages)
+	if (ptr == MAP_FAILED) {
+
+		// Map an extra huge page and trim either side of the boundary
+		char *raw = static_cast<char*>(mmap(NULL, mapBytes + hugePageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+		if (raw == MAP_FAILED)
+			throw bad_alloc();
+		size_t lead = (hugePageSize - reinterpret_cast<uintptr_t>(raw) % hugePageSize) % hugePageSize;
+		if (lead > 0)
+			munmap(raw, lead);
+		munmap(raw + lead + mapBytes, hugePageSize - lead);
+		ptr = raw + lead;
+
+		// Ask for transparent huge pages
+#ifdef HUGE_PAGES
+		madvise(ptr, mapBytes, MADV_HUGEPAGE);
+#endif
+	}
+
+	// Spread pages over all NUMA nodes (before they are touched, left to first touch if it fails)
+#ifdef NUMA_INTERLEAVE
+	unsigned long nodeMask = ~0UL;
+	syscall(SYS_mbind, ptr, mapBytes, MPOL_INTERLEAVE, &nodeMask, sizeof(nodeMask) * 8, 0);
+#endif
+
+	// Return
+	return ptr;
+}
+
+// Free memory of a lattice array
+void Utils::latticeFree(void *ptr, size_t bytes) {
+
+	// Small arrays came from the heap, large arrays have their own mapping
+	if (bytes < hugePageSize)
+		free(ptr);
+	else
+		munmap(ptr, ((bytes + hugePageSize - 1) / hugePageSize) * hugePageSize);
+}
+
+// Get the page size backing an address (read from the memory map of the process)
+string Utils::getPageString(const void *ptr) {
+
+	// Open memory map
+	ifstream file("/proc/self/smaps");
+	if (!file.is_open())
+		return "unknown";
+
+	// Find mapping which holds the address
+	uintptr_t addr = reinterpret_cast<uintptr_t>(ptr);
+	bool found = false;
+	long sizeKB = 0, pageKB = 0, hugeKB = 0;
+	string line;
+	while (getline(file, line)) {
+
+		// Start of a mapping (start-end address range)
+		unsigned long start, end;
+		if (sscanf(line.c_str(), "%lx-%lx ", &start, &end) == 2) {
+			if (found == true)
+				break;
+			found = (addr >= start && addr < end);
+			continue;
+		}
+
+		// Read values of the mapping
+		if (found == true) {
+			istringstream iss(line);
+			string key;
+			long value;
+			iss >> key >> value;
+			if (key == "Size:")
+				sizeKB = value;
+			else if (key == "KernelPageSize:")
+				pageKB = value;
+			else if (key == "AnonHugePages:")
+				hugeKB = value;
+		}
+	}
+
+	// Not mapped
+	if (found == false)
+		return "unknown";
+
+	// Explicit huge pages
+	if (pageKB * 1024 >= static_cast<long>(hugePageSize))
+		return to_string(pageKB) + " kB pages (explicit huge pages)";
+
+	// Normal pages (some may be merged into transparent huge pages)
+	else if (hugeKB > 0)
+		return to_string(pageKB) + " kB pages (" + to_string(hugeKB) + " of " + to_string(sizeKB) + " kB in transparent huge pages)";
+	else
+		return to_string(pageKB) + " kB pages";
+}
+
 // Convert seconds to hours:minutes:seconds
 array<int, 3> Utils::secs2hms(double seconds) {
 
@@ -284,6 +479,58 @@ string Utils::getBoundaryString(eLatType BCType) {
 	return str;
 }
 
+// Get string for population layout
+string Utils::getLayoutString(eLayoutType layout) {
+
+	// String
+	string str;
+
+	// Check against possible options
+	if (layout == eAoS)
+		str = "AoS";
+	else if (layout == eSoA)
+		str = "SoA";
+	else if (layout == eAoSoA)
+		str = "AoSoA (block width = " + to_string(blockWidth) + ")";
+
+	// Return
+	return str;
+}
+
+// Get string for population storage precision
+string Utils::getPrecisionString(ePrecisionType precision) {
+
+	// String
+	string str;
+
+	// Check against possible options
+	if (precision == eDouble)
+		str = "Double";
+	else if (precision == eFloat)
+		str = "Float";
+	else if (precision == eFloatDelta)
+		str = "Float (deviation from reference equilibrium)";
+
+	// Return
+	return str;
+}
+
+// Get string for collision operator
+string Utils::getCollisionString(eCollisionType collision) {
+
+	// String
+	string str;
+
+	// Check against possible options
+	if (collision == eBGK)
+		str = "BGK";
+	else if (collision == eCentralMoments)
+		str = "Central Moments";
+
+	// Return
+	return str;
+}
+
 // Solve linear system using LAPACK routines
 vector<double> Utils::solveLAPACK(vector<double> A, vector<double> b, int BC) {
 
@@ -309,3 +556,241 @@ vector<double> Utils::solveLAPACK(vector<double> A, vector<double> b, int BC) {
 	// Return RHS
 	return b;
 }
+
+// Solve sparse (CSR) linear system using Jacobi preconditioned BiCGSTAB (x holds the initial guess on entry and the best iterate on exit, work is resized as needed)
+bool Utils::solveBiCGSTAB(const vector<int> &rowStart, const vector<int> &col, const vector<double> &val, const vector<double> &b, vector<double> &x, vector<double> &work, int &its, double &res) {
+
+	// Size of system
+	size_t dim = b.size();
+
+	// Split workspace into vectors
+	work.resize(10 * dim);
+	double *diagInv = work.data(), *r = diagInv + dim, *rHat = r + dim, *p = rHat + dim, *v = p + dim, *y = v + dim, *s = y + dim, *z = s + dim, *t = z + dim, *xBest = t + dim;
+
+	// Get inverse of diagonal for preconditioner
+	for (size_t i = 0; i < dim; i++) {
+		diagInv[i] = 1.0;
+		for (int k = rowStart[i]; k < rowStart[i+1]; k++) {
+			if (col[k] == static_cast<int>(i) && val[k] != 0.0)
+				diagInv[i] = 1.0 / val[k];
+		}
+	}
+
+	// Sparse matrix vector product
+	auto matVec = [&] (const double *in, double *out) {
+		for (size_t i = 0; i < dim; i++) {
+			double sum = 0.0;
+			for (int k = rowStart[i]; k < rowStart[i+1]; k++)
+				sum += val[k] * in[col[k]];
+			out[i] = sum;
+		}
+	};
+
+	// Dot product
+	auto dot = [dim] (const double *a, const double *c) {
+		double sum = 0.0;
+		for (size_t i = 0; i < dim; i++)
+			sum += a[i] * c[i];
+		return sum;
+	};
+
+	// Keep the iterate with the smallest residual
+	double bb = dot(b.data(), b.data());
+	double bestRes = numeric_limits<double>::max();
+	auto keepBest = [&] (double resIt) {
+		res = resIt;
+		if (res < bestRes) {
+			bestRes = res;
+			copy(x.begin(), x.end(), xBest);
+		}
+		return (res <= sparseTol);
+	};
+
+	// Start from the initial guess and restart once from the best iterate after a breakdown or stagnation
+	its = 0;
+	for (int attempt = 0; attempt < 2; attempt++) {
+
+		// Get initial residual
+		if (attempt > 0)
+			copy(xBest, xBest + dim, x.begin());
+		matVec(x.data(), r);
+		for (size_t i = 0; i < dim; i++) {
+			r[i] = b[i] - r[i];
+			rHat[i] = r[i];
+			p[i] = 0.0;
+			v[i] = 0.0;
+		}
+		if (keepBest(sqrt(dot(r, r) / bb)))
+			return true;
+
+		// Iterate
+		double rho = 1.0, alpha = 1.0, omega = 1.0;
+		int lastBest = its;
+		for (int it = 0; it < sparseMaxIt && its - lastBest < sparseStallIt; it++, its++) {
+
+			// Get search direction (stop on breakdown)
+			double rhoNew = dot(rHat, r);
+			if (rhoNew == 0.0 || !isfinite(rhoNew))
+				break;
+			double beta = (rhoNew / rho) * (alpha / omega);
+			rho = rhoNew;
+			for (size_t i = 0; i < dim; i++) {
+				p[i] = r[i] + beta * (p[i] - omega * v[i]);
+				y[i] = diagInv[i] * p[i];
+			}
+
+			// First half step
+			matVec(y, v);
+			double rHatV = dot(rHat, v);
+			if (rHatV == 0.0 || !isfinite(rHatV))
+				break;
+			alpha = rho / rHatV;
+			for (size_t i = 0; i < dim; i++) {
+				x[i] += alpha * y[i];
+				s[i] = r[i] - alpha * v[i];
+			}
+			double prevBest = bestRes;
+			if (keepBest(sqrt(dot(s, s) / bb))) {
+				its++;
+				return true;
+			}
+
+			// Second half step
+			for (size_t i = 0; i < dim; i++)
+				z[i] = diagInv[i] * s[i];
+			matVec(z, t);
+			omega = dot(t, s) / dot(t, t);
+			if (omega == 0.0 || !isfinite(omega))
+				break;
+			for (size_t i = 0; i < dim; i++) {
+				x[i] += omega * z[i];
+				r[i] = s[i] - omega * t[i];
+			}
+			if (keepBest(sqrt(dot(r, r) / bb))) {
+				its++;
+				return true;
+			}
+
+			// Track when the residual last improved
+			if (bestRes < prevBest)
+				lastBest = its;
+		}
+	}
+
+	// Not converged so return the best iterate
+	copy(xBest, xBest + dim, x.begin());
+	res = bestRes;
+	return false;
+}
+
+// Get rank which owns item idx when n items are split into contiguous blocks over the ranks
+int Utils::blockRank(int idx, int n, int nRanks) {
+
+	// Block of rank r starts at r * n / nRanks
+	return static_cast<int>(((static_cast<long long>(idx) + 1) * nRanks - 1) / n);
+}
+
+// Share items between ranks (width values per item, each rank sends the items it owns)
+void Utils::shareOwned(vector<double> &vals, int width, const vector<int> &owner) {
+
+#ifdef MPI_SLABS
+
+	// Get rank and number of ranks
+	int rank, nRanks;
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+	MPI_Comm_size(MPI_COMM_WORLD, &nRanks);
+
+	// Pack the items this rank owns and count the values coming from each rank
+	vector<double> sendBuf;
+	vector<int> counts(nRanks, 0);
+	for (size_t n = 0; n < owner.size(); n++) {
+		counts[owner[n]] += width;
+		if (owner[n] == rank)
+			sendBuf.insert(sendBuf.end(), vals.begin() + n * width, vals.begin() + (n + 1) * width);
+	}
+
+	// Get start of each rank's values
+	vector<int> displs(nRanks, 0);
+	for (int r = 1; r < nRanks; r++)
+		displs[r] = displs[r - 1] + counts[r - 1];
+
+	// Gather the values from all ranks
+	vector<double> recvBuf(owner.size() * width);
+	MPI_Allgatherv(sendBuf.data(), static_cast<int>(sendBuf.size()), MPI_DOUBLE, recvBuf.data(), counts.data(), displs.data(), MPI_DOUBLE, MPI_COMM_WORLD);
+
+	// Unpack them in item order (exact copies so every rank ends up with identical values)
+	for (size_t n = 0; n < owner.size(); n++) {
+		copy(recvBuf.begin() + displs[owner[n]], recvBuf.begin() + displs[owner[n]] + width, vals.begin() + n * width);
+		displs[owner[n]] += width;
+	}
+#else
+	(void)vals;
+	(void)width;
+	(void)owner;
+#endif
+}
+
+// Send values to other ranks (one buffer for each rank) and get the values sent to this rank (one buffer from each rank)
+void Utils::exchange(const vector<vector<double>> &sendBuf, vector<vector<double>> &recvBuf) {
+
+#ifdef MPI_SLABS
+
+	// Get number of ranks
+	int nRanks;
+	MPI_Comm_size(MPI_COMM_WORLD, &nRanks);
+
+	// Tell each rank how many values are coming
+	vector<int> sendCounts(nRanks), recvCounts(nRanks);
+	for (int r = 0; r < nRanks; r++)
+		sendCounts[r] = static_cast<int>(sendBuf[r].size());
+	MPI_Alltoall(sendCounts.data(), 1, MPI_INT, recvCounts.data(), 1, MPI_INT, MPI_COMM_WORLD);
+
+	// Pack the buffers back to back
+	vector<int> sendDispls(nRanks, 0), recvDispls(nRanks, 0);
+	for (int r = 1; r < nRanks; r++) {
+		sendDispls[r] = sendDispls[r - 1] + sendCounts[r - 1];
+		recvDispls[r] = recvDispls[r - 1] + recvCounts[r - 1];
+	}
+	vector<double> sendVals;
+	sendVals.reserve(sendDispls[nRanks - 1] + sendCounts[nRanks - 1]);
+	for (int r = 0; r < nRanks; r++)
+		sendVals.insert(sendVals.end(), sendBuf[r].begin(), sendBuf[r].end());
+
+	// Send them (only ranks with something to say to each other exchange data)
+	vector<double> recvVals(recvDispls[nRanks - 1] + recvCounts[nRanks - 1]);
+	MPI_Alltoallv(sendVals.data(), sendCounts.data(), sendDispls.data(), MPI_DOUBLE, recvVals.data(), recvCounts.data(), recvDispls.data(), MPI_DOUBLE, MPI_COMM_WORLD);
+
+	// Unpack into one buffer from each rank
+	recvBuf.resize(nRanks);
+	for (int r = 0; r < nRanks; r++)
+		recvBuf[r].assign(recvVals.begin() + recvDispls[r], recvVals.begin() + recvDispls[r] + recvCounts[r]);
+#else
+	recvBuf = sendBuf;
+#endif
+}
+
+// Broadcast values from one rank to the others
+void Utils::broadcast(vector<double> &vals, int root) {
+
+#ifdef MPI_SLABS
+
+	// Send the size first
+	int size = static_cast<int>(vals.size());
+	MPI_Bcast(&size, 1, MPI_INT, root, MPI_COMM_WORLD);
+
+	// Then the values
+	vals.resize(size);
+	MPI_Bcast(vals.data(), size, MPI_DOUBLE, root, MPI_COMM_WORLD);
+#else
+	(void)vals;
+	(void)root;
+#endif
+}
+
+// Wait for all ranks
+void Utils::barrier() {
+
+#ifdef MPI_SLABS
+	MPI_Barrier(MPI_COMM_WORLD);
+#endif
+}
@@ -22,7 +22,18 @@
 #include "../inc/Utils.h"
 
 // ***** Main function ***** //
-int main() {
+int main(int argc, char *argv[]) {
+
+	// Start MPI (any one thread of a rank may call it) and only let the first rank write to screen
+#ifdef MPI_SLABS
+	int provided, rank;
+	MPI_Init_thread(NULL, NULL, MPI_THREAD_SERIALIZED, &provided);
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+	if (rank > 0)
+		cout.setstate(ios::failbit);
+	if (provided < MPI_THREAD_SERIALIZED)
+		ERROR("MPI library does not support calls from OpenMP threads...exiting");
+#endif
 
 	// Write out header
 	Utils::writeHeader();
@@ -33,11 +44,29 @@ int main() {
 	// Time the code
 	double start = omp_get_wtime();
 
+	// Read in the case parameters
+	readCaseConfig();
+
+	// Only write out the case parameters if asked (./LIFE --case, used to check case.config files)
+	if (argc > 1 && string(argv[1]) == "--case") {
+		cout << endl << endl;
+		writeCaseConfig(cout);
+#ifdef MPI_SLABS
+		MPI_Finalize();
+#endif
+		return 0;
+	}
+
 	// Set number of threads
 #ifdef THREADS
 	omp_set_num_threads(THREADS);
 #endif
 
+	// Pin threads to cores (before the lattice arrays are first touched)
+#ifdef PIN_THREADS
+	Utils::pinThreads();
+#endif
+
 	// Create grid and initialise values
 	GridClass grid;
 
@@ -91,4 +120,9 @@ int main() {
 	// Finish timing
 	double end = omp_get_wtime();
 	cout << fixed << setprecision(2) << endl << endl << "Simulation took " << end - start << " seconds" << endl << endl << endl;
+
+	// Finish MPI
+#ifdef MPI_SLABS
+	MPI_Finalize();
+#endif
 }
@@ -0,0 +1,413 @@
+/*
+    LIFE: Lattice boltzmann-Immersed boundary-Finite Element
+    Copyright (C) 2019 Joseph O'Connor
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Includes
+#include "../inc/params.h"
+#include "../inc/Utils.h"
+
+// Case parameters (set by readCaseConfig)
+eCollisionType collisionType;
+double inletRamp;
+double womersley;
+double smagorinsky;
+bool uniEpsilon;
+double initialDeflection;
+bool vtkOutput;
+bool vtkFEMOutput;
+bool forcesOutput;
+bool tipsOutput;
+int Nx;
+int Ny;
+double height_p;
+double rho_p;
+double nu_p;
+double ux0_p;
+double uy0_p;
+double gravityX;
+double gravityY;
+double dpdx;
+double dpdy;
+eLatType wallLeft;
+eLatType wallRight;
+eLatType wallBottom;
+eLatType wallTop;
+eProfileType profile;
+double uxInlet_p;
+double uyInlet_p;
+double alpha;
+double delta;
+double relaxMax;
+double subTol;
+double tStep;
+double omega;
+int nSteps;
+int tinfo;
+int tVTK;
+int tRestart;
+double ref_nu;
+double ref_rho;
+double ref_P;
+double ref_L;
+double ref_U;
+int PRECISION;
+
+// Type of a case parameter
+enum eParamType {eIntParam, eDoubleParam, eBoolParam, eLatParam, eProfileParam, eCollisionParam};
+
+// Case parameter (name, type, where it is stored and its default expression)
+struct CaseParam {
+	string name;							// Name in case.config
+	eParamType type;						// Type of parameter
+	void *ptr;								// Global it is stored in
+	string expr;							// Expression (default unless set in case.config)
+};
+
+// Case parameters and their defaults (expressions can use any other parameter)
+static vector<CaseParam> caseParams = {
+	{"resFactor", eIntParam, NULL, "2"},
+	{"collisionType", eCollisionParam, &collisionType, "eBGK"},
+	{"inletRamp", eDoubleParam, &inletRamp, "2.0"},
+	{"womersley", eDoubleParam, &womersley, "0.0"},
+	{"smagorinsky", eDoubleParam, &smagorinsky, "0.0"},
+	{"uniEpsilon", eBoolParam, &uniEpsilon, "true"},
+	{"initialDeflection", eDoubleParam, &initialDeflection, "0.0"},
+	{"vtkOutput", eBoolParam, &vtkOutput, "true"},
+	{"vtkFEMOutput", eBoolParam, &vtkFEMOutput, "false"},
+	{"forcesOutput", eBoolParam, &forcesOutput, "true"},
+	{"tipsOutput", eBoolParam, &tipsOutput, "true"},
+	{"Nx", eIntParam, &Nx, "resFactor * 250 + 1"},
+	{"Ny", eIntParam, &Ny, "resFactor * 41 + 1"},
+	{"height_p", eDoubleParam, &height_p, "0.41"},
+	{"rho_p", eDoubleParam, &rho_p, "1000.0"},
+	{"nu_p", eDoubleParam, &nu_p, "0.001"},
+	{"ux0_p", eDoubleParam, &ux0_p, "0.0"},
+	{"uy0_p", eDoubleParam, &uy0_p, "0.0"},
+	{"gravityX", eDoubleParam, &gravityX, "0.0"},
+	{"gravityY", eDoubleParam, &gravityY, "0.0"},
+	{"dpdx", eDoubleParam, &dpdx, "0.0"},
+	{"dpdy", eDoubleParam, &dpdy, "0.0"},
+	{"wallLeft", eLatParam, &wallLeft, "eVelocity"},
+	{"wallRight", eLatParam, &wallRight, "ePressure"},
+	{"wallBottom", eLatParam, &wallBottom, "eWall"},
+	{"wallTop", eLatParam, &wallTop, "eWall"},
+	{"profile", eProfileParam, &profile, "eParabolic"},
+	{"uxInlet_p", eDoubleParam, &uxInlet_p, "1.0"},
+	{"uyInlet_p", eDoubleParam, &uyInlet_p, "0.0"},
+	{"alpha", eDoubleParam, &alpha, "0.25"},
+	{"delta", eDoubleParam, &delta, "0.5"},
+	{"relaxMax", eDoubleParam, &relaxMax, "1.0"},
+	{"subTol", eDoubleParam, &subTol, "1e-8"},
+	{"tStep", eDoubleParam, &tStep, "0.001 / (resFactor * resFactor)"},
+	{"omega", eDoubleParam, &omega, "1.0 / (nu_p * tStep / (pow(1.0 / sqrt(3.0), 2.0) * pow(height_p / (Ny - 1), 2.0)) + 0.5)"},
+	{"nSteps", eIntParam, &nSteps, "500"},
+	{"tinfo", eIntParam, &tinfo, "nSteps / 50"},
+	{"tVTK", eIntParam, &tVTK, "nSteps / 10"},
+	{"tRestart", eIntParam, &tRestart, "nSteps / 5"},
+	{"ref_nu", eDoubleParam, &ref_nu, "nu_p"},
+	{"ref_rho", eDoubleParam, &ref_rho, "rho_p"},
+	{"ref_P", eDoubleParam, &ref_P, "0.0"},
+	{"ref_L", eDoubleParam, &ref_L, "0.1"},
+	{"ref_U", eDoubleParam, &ref_U, "uxInlet_p"},
+	{"PRECISION", eIntParam, &PRECISION, "10"}
+};
+
+// Names which can be used as values in case.config
+static map<string, double> caseConstants = {
+	{"true", 1.0}, {"false", 0.0},
+	{"eBGK", eBGK}, {"eCentralMoments", eCentralMoments},
+	{"eFluid", eFluid}, {"eWall", eWall}, {"eVelocity", eVelocity}, {"eFreeSlip", eFreeSlip}, {"ePressure", ePressure}, {"eConvective", eConvective},
+	{"eParabolic", eParabolic}, {"eShear", eShear}, {"eBoundaryLayer", eBoundaryLayer}, {"eUniform", eUniform}
+};
+
+// Evaluated parameters and those currently being evaluated (for catching circular definitions)
+static map<string, double> caseValues;
+static vector<string> caseStack;
+
+// Forward declaration
+static double caseValue(const string &name);
+
+// Expression in case.config (numbers, parameters, + - * /, brackets and a few maths functions)
+struct CaseExpression {
+
+	// Constructor
+	CaseExpression(const string &exprIn, const string &nameIn) : expr(exprIn), name(nameIn), pos(0) {};
+
+	// Members
+	const string &expr;						// Expression
+	const string &name;						// Parameter being evaluated
+	size_t pos;								// Current position
+
+	// Evaluate whole expression
+	double evaluate() {
+		double val = sum();
+		skipSpace();
+		if (pos != expr.size())
+			fail();
+		return val;
+	}
+
+	// Error in expression
+	double fail() {
+		ERROR("Could not evaluate " + name + " = " + expr + " in case.config...exiting");
+		return 0.0;
+	}
+
+	// Skip whitespace
+	void skipSpace() {
+		while (pos < expr.size() && isspace(expr[pos]))
+			pos++;
+	}
+
+	// Check for a character and consume it
+	bool accept(char ch) {
+		skipSpace();
+		if (pos < expr.size() && expr[pos] == ch) {
+			pos++;
+			return true;
+		}
+		return false;
+	}
+
+	// Terms added together
+	double sum() {
+		double val = product();
+		while (true) {
+			if (accept('+'))
+				val = val + product();
+			else if (accept('-'))
+				val = val - product();
+			else
+				return val;
+		}
+	}
+
+	// Factors multiplied together
+	double product() {
+		double val = factor();
+		while (true) {
+			if (accept('*'))
+				val = val * factor();
+			else if (accept('/'))
+				val = val / factor();
+			else
+				return val;
+		}
+	}
+
+	// Number, name, function call or bracketed expression
+	double factor() {
+
+		// Unary signs and brackets
+		if (accept('-'))
+			return -factor();
+		if (accept('+'))
+			return factor();
+		if (accept('(')) {
+			double val = sum();
+			if (!accept(')'))
+				fail();
+			return val;
+		}
+
+		// Number
+		skipSpace();
+		if (pos < expr.size() && (isdigit(expr[pos]) || expr[pos] == '.')) {
+			char *end;
+			double val = strtod(expr.c_str() + pos, &end);
+			pos = end - expr.c_str();
+			return val;
+		}
+
+		// Name
+		size_t start = pos;
+		while (pos < expr.size() && (isalnum(expr[pos]) || expr[pos] == '_'))
+			pos++;
+		if (pos == start)
+			return fail();
+		string word = expr.substr(start, pos - start);
+
+		// Function call
+		if (accept('(')) {
+			vector<double> args(1, sum());
+			while (accept(','))
+				args.push_back(sum());
+			if (!accept(')'))
+				fail();
+			if (word == "pow" && args.size() == 2)
+				return pow(args[0], args[1]);
+			else if (args.size() != 1)
+				fail();
+			else if (word == "sqrt")
+				return sqrt(args[0]);
+			else if (word == "round")
+				return round(args[0]);
+			else if (word == "floor")
+				return floor(args[0]);
+			else if (word == "ceil")
+				return ceil(args[0]);
+			else if (word == "cos")
+				return cos(args[0]);
+			else if (word == "sin")
+				return sin(args[0]);
+			else if (word == "exp")
+				return exp(args[0]);
+			else if (word == "log")
+				return log(args[0]);
+			return fail();
+		}
+
+		// Parameter or constant
+		return caseValue(word);
+	}
+};
+
+// Get the value of a parameter or constant (evaluated the first time it is needed)
+static double caseValue(const string &name) {
+
+	// Already evaluated
+	if (caseValues.count(name) > 0)
+		return caseValues[name];
+
+	// Constants
+	if (caseConstants.count(name) > 0)
+		return caseConstants[name];
+
+	// Find parameter
+	size_t p = 0;
+	while (p < caseParams.size() && caseParams[p].name != name)
+		p++;
+	if (p == caseParams.size())
+		ERROR("Unknown name " + name + " in case.config...exiting");
+
+	// Check it is not defined in terms of itself
+	if (find(caseStack.begin(), caseStack.end(), name) != caseStack.end())
+		ERROR("Circular definition of " + name + " in case.config...exiting");
+
+	// Evaluate (integer parameters are truncated like the integer division they used to be)
+	caseStack.push_back(name);
+	double val = CaseExpression(caseParams[p].expr, name).evaluate();
+	if (caseParams[p].type != eDoubleParam)
+		val = static_cast<double>(static_cast<int>(val));
+	caseStack.pop_back();
+
+	// Store and return
+	caseValues[name] = val;
+	return val;
+}
+
+// Read in the case parameters from input/case.config
+void readCaseConfig() {
+
+	// Write out
+	cout << endl << endl << "Reading case configuration...";
+
+	// Open config file
+	ifstream file;
+	file.open("input/case.config");
+
+	// Handle failure to open
+	if (!file.is_open())
+		ERROR("Error opening case configuration file (input/case.config)...exiting");
+
+	// Read each line as NAME = EXPRESSION (everything after # is a comment)
+	string line;
+	vector<string> setNames;
+	while (getline(file, line)) {
+
+		// Strip comments and skip empty lines
+		line = line.substr(0, line.find('#'));
+		if (line.find_first_not_of(" \t\r") == string::npos)
+			continue;
+
+		// Split into name and expression
+		size_t eq = line.find('=');
+		if (eq == string::npos)
+			ERROR("Line \"" + line + "\" in case.config is not NAME = VALUE...exiting");
+		string name = line.substr(0, eq);
+		string expr = line.substr(eq + 1);
+		name.erase(0, name.find_first_not_of(" \t"));
+		name.erase(name.find_last_not_of(" \t\r") + 1);
+		expr.erase(0, expr.find_first_not_of(" \t"));
+		expr.erase(expr.find_last_not_of(" \t\r") + 1);
+
+		// Find parameter and set its expression
+		size_t p = 0;
+		while (p < caseParams.size() && caseParams[p].name != name)
+			p++;
+		if (p == caseParams.size())
+			ERROR("Unknown parameter " + name + " in case.config...exiting");
+		if (find(setNames.begin(), setNames.end(), name) != setNames.end())
+			ERROR("Parameter " + name + " is set more than once in case.config...exiting");
+		caseParams[p].expr = expr;
+		setNames.push_back(name);
+	}
+
+	// Evaluate all parameters and store them
+	for (size_t p = 0; p < caseParams.size(); p++) {
+
+		// Get value
+		double val = caseValue(caseParams[p].name);
+
+		// Check enumerations are in range
+		int maxEnum = 0;
+		if (caseParams[p].type == eLatParam)
+			maxEnum = eConvective;
+		else if (caseParams[p].type == eProfileParam)
+			maxEnum = eUniform;
+		else if (caseParams[p].type == eCollisionParam)
+			maxEnum = eCentralMoments;
+		if (maxEnum > 0 && (val < 0 || val > maxEnum))
+			ERROR("Invalid value for " + caseParams[p].name + " in case.config...exiting");
+
+		// Store
+		if (caseParams[p].ptr == NULL)
+			continue;
+		else if (caseParams[p].type == eDoubleParam)
+			*static_cast<double*>(caseParams[p].ptr) = val;
+		else if (caseParams[p].type == eIntParam)
+			*static_cast<int*>(caseParams[p].ptr) = static_cast<int>(val);
+		else if (caseParams[p].type == eBoolParam)
+			*static_cast<bool*>(caseParams[p].ptr) = (val != 0.0);
+		else if (caseParams[p].type == eLatParam)
+			*static_cast<eLatType*>(caseParams[p].ptr) = static_cast<eLatType>(val);
+		else if (caseParams[p].type == eProfileParam)
+			*static_cast<eProfileType*>(caseParams[p].ptr) = static_cast<eProfileType>(val);
+		else if (caseParams[p].type == eCollisionParam)
+			*static_cast<eCollisionType*>(caseParams[p].ptr) = static_cast<eCollisionType>(val);
+	}
+
+	// Check the lattice and output frequencies
+	if (Nx < 1 || Ny < 2)
+		ERROR("Lattice must have Nx > 0 and Ny > 1 in case.config...exiting");
+	if (tinfo < 1 || tVTK < 1 || tRestart < 0)
+		ERROR("Output frequencies tinfo and tVTK must be positive (and tRestart not negative) in case.config...exiting");
+
+	// Write out
+	cout << "finished";
+}
+
+// Write out the value of every case parameter (after readCaseConfig, enumerations and bools as numbers)
+void writeCaseConfig(ostream &output) {
+
+	// Full precision so values can be compared exactly
+	output << setprecision(17);
+	for (size_t p = 0; p < caseParams.size(); p++) {
+		if (caseParams[p].ptr != NULL)
+			output << caseParams[p].name << " = " << caseValues[caseParams[p].name] << "\n";
+	}
+}
@@ -0,0 +1,138 @@
+/*
+    LIFE: Lattice boltzmann-Immersed boundary-Finite Element
+    Copyright (C) 2019 Joseph O'Connor
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PARAMS_H	// PARAMS_H
+#define PARAMS_H
+
+// Include defs
+#include "defs.h"
+
+// Build options (the case itself is set at run time in input/case.config)
+
+// Set number of OMP threads (if commented then it will use system max)
+//#define THREADS 12
+//#define PIN_THREADS					// Pin each OMP thread to its own core (spread over the available cores)
+
+// Memory options for the lattice arrays
+//#define HUGE_PAGES					// Back large lattice arrays with huge pages (explicit if reserved, otherwise transparent)
+//#define NUMA_INTERLEAVE				// Interleave pages of large lattice arrays over the NUMA nodes (instead of first touch)
+
+// Split the lattice into x-slabs over MPI ranks (run with mpirun, OMP threads within each rank)
+//#define MPI_SLABS
+
+// Reduction options
+#define ORDERED						// For deterministic reduction operations
+
+// Kernel options
+#define LAYOUT eAoS						// Population storage layout (eAoS, eSoA or eAoSoA)
+#define POP_PRECISION eDouble			// Population storage precision (eDouble, eFloat or eFloatDelta)
+//#define AA_PATTERN					// In-place AA pattern streaming (no f_n copy of the populations)
+//#define HALO							// Pad populations with a ghost layer for periodic streaming
+//#define VECTORISED					// SIMD collision kernels across consecutive sites (runtime dispatch)
+//#define FUSED							// Fused pull kernel (stream, macroscopic and collide in one pass)
+//#define MOMENTS						// Store six moments per site instead of populations (regularised BGK)
+//#define SPARSE						// Store non-solid sites only, numbered in runs up each column (solid mask read from input/solid.pgm)
+//#define LEAN_MEMORY					// Keep start of timestep values at BC sites only and a uniform body force (no per-site force array)
+//#define TILED							// Sweep the lattice in TILE_X by TILE_Y tiles of sites
+#define TILE_X 16						// Tile size in x-direction (lattice sites)
+#define TILE_Y 64						// Tile size in y-direction
+
+// IBM options
+//#define LAZY_EPSILON 1e-3				// Keep support and epsilon of a flexible body until a marker moves this far (lattice units)
+
+// Case parameters (read in from input/case.config by readCaseConfig, defaults are in params.cpp)
+
+// Simulation options
+extern eCollisionType collisionType;	// Collision operator (eBGK or eCentralMoments)
+extern double inletRamp;				// Inlet velocity ramp-up time (s, 0 for off)
+extern double womersley;				// Womersley number for oscillating pressure gradients (0 for off)
+extern double smagorinsky;				// Smagorinsky constant for the LES eddy viscosity (0 for off)
+extern bool uniEpsilon;					// Calculate epsilon over all IBM bodies at once
+extern double initialDeflection;		// Set an initial deflection (fraction of L, 0 for off)
+
+// Outputs
+extern bool vtkOutput;					// Write out VTK
+extern bool vtkFEMOutput;				// Write out the FEM VTK
+extern bool forcesOutput;				// Write out forces on structures
+extern bool tipsOutput;					// Write out tip positions
+
+// Domain setup (lattice)
+extern int Nx;							// Number of lattice sites in x-direction
+extern int Ny;							// Number of lattice sites in y-direction
+
+// Domain setup (physical)
+extern double height_p;					// Domain height (m)
+extern double rho_p;					// Fluid density (kg/m^3)
+extern double nu_p;						// Fluid kinematic viscosity (m^2/s)
+
+// Initial conditions
+extern double ux0_p;					// Initial x-velocity (m/s)
+extern double uy0_p;					// Initial y-velocity (m/s)
+
+// Gravity and pressure gradient
+extern double gravityX;					// Gravity component in x-direction (m/s^2)
+extern double gravityY;					// Gravity component in y-direction (m/s^2)
+extern double dpdx;						// Pressure gradient in x-direction (Pa/m)
+extern double dpdy;						// Pressure gradient in y-direction (Pa/m)
+
+// Boundary conditions
+extern eLatType wallLeft;				// Boundary condition at left wall (eFluid for periodic)
+extern eLatType wallRight;				// Boundary condition at right wall
+extern eLatType wallBottom;				// Boundary condition at bottom wall
+extern eLatType wallTop;				// Boundary condition at top wall
+extern eProfileType profile;			// Inlet profile shape
+
+// Inlet conditions
+extern double uxInlet_p;				// Inlet x-velocity (m/s)
+extern double uyInlet_p;				// Inlet y-velocity (m/s)
+
+// FEM Newmark integration parameters
+extern double alpha;					// Alpha parameter
+extern double delta;					// Delta parameter
+
+// FSI Coupling parameters
+extern double relaxMax;					// Relaxation parameter (initial guess)
+extern double subTol;					// Tolerance for subiterations
+
+// Time step and relaxation
+extern double tStep;					// Time step (s)
+extern double omega;					// Relaxation frequency
+
+// Number of time steps and how often to write out
+extern int nSteps;						// Number of time steps
+extern int tinfo;						// Frequency to write out info and logs
+extern int tVTK;						// Frequency to write out VTK
+extern int tRestart;					// Frequency to write out restart files (0 for off)
+
+// Reference values
+extern double ref_nu;					// Reference kinematic viscosity (m^2/s)
+extern double ref_rho;					// Reference density (kg/m^3)
+extern double ref_P;					// Reference pressure (Pa)
+extern double ref_L;					// Reference length (m)
+extern double ref_U;					// Reference velocity (m/s)
+
+// Precision for ASCII output
+extern int PRECISION;
+
+// Read in the case parameters from input/case.config
+void readCaseConfig();
+
+// Write out the value of every case parameter
+void writeCaseConfig(ostream &output);
+
+#endif	// PARAMS_H
@@ -0,0 +1,42 @@
+#!/bin/bash
+
+# Build LIFE in a scratch copy of the source so inc/params.h is never edited (sourced by the testing scripts)
+#   buildLife <params.h> <build directory> [OPTION or OPTION=value ...]
+# OPTION enables a build option and OPTION=value sets it (e.g. AA_PATTERN or LAYOUT=eSoA)
+buildLife() {
+
+	# Get the params.h to start from and the build directory
+	local params=$1
+	local buildDir=$2
+	shift 2
+
+	# Copy the source
+	rm -rf $buildDir
+	mkdir -p $buildDir/obj
+	cp -r ../src ../inc ../makefile $buildDir/.
+	cp $params $buildDir/inc/params.h
+
+	# Apply the option overrides
+	local opt key val
+	for opt in "$@"
+	do
+		key=${opt%%=*}
+		val=""
+		if [ "$key" != "$opt" ]; then
+			val=" ${opt#*=}"
+		fi
+		if grep -q "#define $key\b" $buildDir/inc/params.h; then
+			sed -i "/#define $key\b/c\#define $key$val" $buildDir/inc/params.h
+		else
+			printf "\nOption $key is not in params.h...exiting\n\n"
+			exit 1
+		fi
+	done
+
+	# Build (output kept in the build directory)
+	if ! (cd $buildDir && make -j 8 > make.log 2>&1); then
+		cat $buildDir/make.log
+		printf "\nBuild failed in $buildDir ($*)...exiting\n\n"
+		exit 1
+	fi
+}
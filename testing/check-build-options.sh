@@ -0,0 +1,182 @@
+#!/bin/bash
+
+# Setup some safe shell options
+set -eu -o pipefail
+
+# Build and compare helpers
+source build-life.sh
+source compare-results.sh
+
+# Cases run with every option set (from their RefData input, see store-ref-data)
+optCases="ChannelFlow LidDrivenCavity Cylinder"
+
+# Cases run with one and several threads (ORDERED reductions and IBM spreading must not depend on the thread count)
+threadCases="ChannelFlow LidDrivenCavity Cylinder TurekHron"
+nThreads=${TEST_THREADS:-4}
+
+# Option sets as build options | cases | tolerance | case.config overrides (key = value, separated by ;)
+# The tolerance is the largest difference allowed relative to the largest value in each output file (0 for byte for byte):
+#   - layouts, streaming patterns, kernels, sparse storage, memory placement and MPI slabs only reorder the same
+#     arithmetic so must match exactly
+#   - single precision storage loses digits every step (eFloatDelta keeps more as it stores the difference from the
+#     rest populations) and Cylinder is left out of eFloat as its early pressure field is below the density round-off
+#   - MOMENTS regularises the non-equilibrium populations so it only reproduces BGK at omega = 1 (nu_p set for tau = 1)
+optionSets=(
+	"LAYOUT=eSoA|$optCases|0|"
+	"LAYOUT=eAoSoA|$optCases|0|"
+	"VECTORISED|$optCases|0|"
+	"LAYOUT=eSoA VECTORISED|$optCases|0|"
+	"AA_PATTERN|$optCases|0|"
+	"HALO|$optCases|0|"
+	"FUSED|$optCases|0|"
+	"TILED|$optCases|0|"
+	"TEMPORAL_STEPS=4|$optCases|0|"
+	"SPARSE|$optCases|0|"
+	"LEAN_MEMORY|$optCases|0|"
+	"HUGE_PAGES NUMA_INTERLEAVE PIN_THREADS|$optCases|0|"
+	"MPI_SLABS|$optCases|0|"
+	"LAZY_EPSILON=1e-3|$optCases|0|"
+	"POP_PRECISION=eFloatDelta|$optCases|1e-4|"
+	"POP_PRECISION=eFloat|ChannelFlow LidDrivenCavity|1e-3|"
+	"MOMENTS|$optCases|1e-8|collisionType = eBGK; nu_p = height_p * height_p / (6 * tStep * (Ny - 1) * (Ny - 1))"
+)
+
+# Check there is reference data for every case (only its input is used)
+for case in $optCases $threadCases
+do
+	if [ ! -d $case/RefData ]; then
+		printf "\nThere is no reference data for $case case...exiting\n\n"
+		exit 1
+	fi
+done
+
+# Run a case from its RefData input in a scratch directory
+#   runCase <LIFE> <case> <run directory> <case.config overrides> [launcher ...]
+runCase() {
+
+	# Get the executable, case, run directory and overrides
+	local exe=$1
+	local case=$2
+	local runDir=$3
+	local overrides=$4
+	shift 4
+
+	# Copy the executable and the case and geometry config files
+	rm -rf $runDir
+	mkdir -p $runDir
+	cp $exe $runDir/.
+	cp -r $case/RefData/input $runDir/.
+
+	# Apply the case.config overrides
+	local entries entry key
+	IFS=';' read -ra entries <<< "$overrides"
+	for entry in "${entries[@]}"
+	do
+		read -r entry <<< "$entry"
+		key=${entry%% =*}
+		if ! grep -q "^$key = " $runDir/input/case.config; then
+			printf "\nParameter $key is not in $case case.config...exiting\n\n"
+			exit 1
+		fi
+		sed -i "s|^$key = .*|$entry|" $runDir/input/case.config
+	done
+
+	# Run the case (twice for TurekHron to test the restart feature)
+	(cd $runDir && "$@" ./LIFE > run.out 2>&1) || return 1
+	if [ $case == "TurekHron" ]; then
+		(cd $runDir && "$@" ./LIFE >> run.out 2>&1) || return 1
+	fi
+}
+
+# Build and run in scratch directories (removed on exit)
+buildRoot=$(mktemp -d)
+trap 'rm -rf "$buildRoot"' EXIT
+
+# Set colors
+normal=$(tput sgr0)
+red=$(tput setaf 1)
+green=$(tput setaf 2)
+
+# Number of fails
+nFails=0
+
+# Build LIFE with the default build options
+printf "\n\n\nBuilding LIFE with the build options of inc/params.h\n\n"
+buildLife ../inc/params.h $buildRoot/default
+defaultExe=$buildRoot/default/LIFE
+
+# Print header
+printf "\n\n\nChecking results do not depend on the number of threads (1 vs $nThreads)...\n\n"
+
+# Run every case with one thread (also the baseline for the option sets) and again with several
+for case in $threadCases
+do
+	runCase $defaultExe $case $buildRoot/runs/default/$case "" env OMP_NUM_THREADS=1
+	runCase $defaultExe $case $buildRoot/runs/threads/$case "" env OMP_NUM_THREADS=$nThreads
+	if compareResults $buildRoot/runs/threads/$case/Results $buildRoot/runs/default/$case/Results 0 > $case.threads.diff; then
+		printf "${green}PASS${normal} -> $case\n\n"
+		rm -f $case.threads.diff
+	else
+		printf "${red}FAIL${normal} -> $case (see $case.threads.diff)\n\n"
+		nFails=$((nFails+1))
+	fi
+done
+
+# Print header
+printf "\n\n\nChecking build option sets against the default build...\n\n"
+
+# Check every option set
+for optionSet in "${optionSets[@]}"
+do
+
+	# Get the options, cases, tolerance and overrides
+	IFS='|' read -r options cases tol overrides <<< "$optionSet"
+	name=$(echo $options | tr ' =' '_-')
+
+	# Build LIFE with the options (the build helper exits on a failed build)
+	buildLife ../inc/params.h $buildRoot/$name $options
+
+	# Launch over two MPI ranks when the lattice is split into slabs
+	launcher=(env OMP_NUM_THREADS=$nThreads)
+	if [[ " $options " == *" MPI_SLABS "* ]]; then
+		launcher+=(mpirun -np 2 --oversubscribe)
+		if [ $(id -u) -eq 0 ]; then
+			launcher+=(--allow-run-as-root)
+		fi
+	fi
+
+	# Run and compare every case
+	for case in $cases
+	do
+
+		# Default build baseline (the single thread run unless the case.config is overridden)
+		baseDir=$buildRoot/runs/default/$case
+		if [ -n "$overrides" ]; then
+			baseDir=$buildRoot/runs/default-$name/$case
+			runCase $defaultExe $case $baseDir "$overrides" env OMP_NUM_THREADS=1
+		fi
+
+		# Run with the options and compare
+		runDir=$buildRoot/runs/$name/$case
+		diffFile=$case.$name.diff
+		if ! runCase $buildRoot/$name/LIFE $case $runDir "$overrides" "${launcher[@]}"; then
+			cp $runDir/run.out $diffFile
+			printf "${red}FAIL${normal} -> $options: $case did not run (see $diffFile)\n\n"
+			nFails=$((nFails+1))
+		elif compareResults $runDir/Results $baseDir/Results $tol > $diffFile; then
+			printf "${green}PASS${normal} -> $options: $case$(sed 's/^/, /' $diffFile)\n\n"
+			rm -f $diffFile
+		else
+			printf "${red}FAIL${normal} -> $options: $case (see $diffFile)\n\n"
+			nFails=$((nFails+1))
+		fi
+	done
+done
+
+# Check if fails is more than zero times
+if [ $nFails -eq 0 ]; then
+	printf "\n${green}ALL BUILD OPTIONS MATCH!${normal}\n\n"
+else
+	printf "\n${red}SOME BUILD OPTIONS DO NOT MATCH!${normal}\n\n"
+	exit 1
+fi
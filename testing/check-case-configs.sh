@@ -0,0 +1,61 @@
+#!/bin/bash
+
+# Setup some safe shell options
+set -eu -o pipefail
+
+# Build LIFE (nothing to rebuild if run-tests has just built it)
+(cd .. && make -j 8)
+lifeExe=$(cd .. && pwd)/LIFE
+
+# Print header
+printf "\n\n\nChecking example case configs against their reference parameters...\n\n"
+
+# Set colors
+normal=$(tput sgr0)
+red=$(tput setaf 1)
+green=$(tput setaf 2)
+
+# Number of fails
+nFails=0
+
+# Check every example
+for d in ../examples/*/
+do
+
+	# Get case path
+	casePath=${d%/}
+
+	# Get case name
+	caseName=${casePath##*/}
+
+	# Check there are reference parameters
+	refFile=CaseParams/$caseName.txt
+	if [ ! -f $refFile ]; then
+		printf "${red}MISSING${normal} -> $refFile\n\n"
+		nFails=$((nFails+1))
+		continue
+	fi
+
+	# Evaluate the case config in a scratch directory
+	caseDir=$(mktemp -d)
+	cp -r $casePath/input $caseDir/.
+	(cd $caseDir && $lifeExe --case > case.out)
+
+	# Compare every evaluated parameter with the reference value
+	if diff <(grep -v "^#" $refFile) <(grep -E "^[A-Za-z_][A-Za-z0-9_]* = " $caseDir/case.out) > $caseName.case.diff; then
+		printf "${green}PASS${normal} -> $caseName\n\n"
+		rm -f $caseName.case.diff
+	else
+		printf "${red}FAIL${normal} -> $caseName (see $caseName.case.diff)\n\n"
+		nFails=$((nFails+1))
+	fi
+	rm -rf $caseDir
+done
+
+# Check if fails is more than zero times
+if [ $nFails -eq 0 ]; then
+	printf "\n${green}ALL CASE CONFIGS MATCH!${normal}\n\n"
+else
+	printf "\n${red}SOME CASE CONFIGS DO NOT MATCH!${normal}\n\n"
+	exit 1
+fi
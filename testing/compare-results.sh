@@ -0,0 +1,81 @@
+#!/bin/bash
+
+# Compare a Results directory with a reference one (sourced by the testing scripts)
+#   compareResults <results> <reference> <tolerance>
+# A tolerance of 0 means every file apart from Log.out must match byte for byte. Otherwise the same files must exist
+# and each .out time history (every column but the first) and VTK file (headers identical, appended data read as
+# Float64) must match to within the tolerance times the largest reference value in that file (restart files not read)
+compareResults() {
+
+	# Get the directories and tolerance
+	local results=$1
+	local ref=$2
+	local tol=$3
+
+	# Bitwise
+	if [ "$tol" == "0" ]; then
+		diff -rq $results $ref --exclude=Log.out
+		return
+	fi
+
+	# Check the same files were written
+	if ! diff <(cd $results && find . -type f ! -name Log.out | sort) <(cd $ref && find . -type f ! -name Log.out | sort); then
+		return 1
+	fi
+
+	# Largest difference relative to the largest reference value of each file
+	local file rel worst=0 worstFile=none
+	for file in $(cd $ref && find . -name "*.out" ! -name Log.out -o -name "*.vt?" | sort)
+	do
+		if [[ $file == *.out ]]; then
+			rel=$(paste <(outNumbers $results/$file) <(outNumbers $ref/$file) | maxRelDiff)
+		elif cmp -s <(sed '/<AppendedData/q' $results/$file) <(sed '/<AppendedData/q' $ref/$file); then
+			rel=$(paste <(vtkNumbers $results/$file) <(vtkNumbers $ref/$file) | maxRelDiff)
+		else
+			rel=inf
+		fi
+		if [ "$rel" == "inf" ] || awk "BEGIN {exit !($rel > $worst)}"; then
+			worst=$rel
+			worstFile=$file
+		fi
+		if [ "$rel" == "inf" ]; then
+			break
+		fi
+	done
+
+	# Report the worst file
+	printf "max rel diff = $worst (${worstFile#./}, tolerance = $tol)\n"
+	[ "$worst" != "inf" ] && awk "BEGIN {exit !($worst <= $tol)}"
+}
+
+# Every number after the first column of a time history (header line skipped)
+outNumbers() {
+	tail -n +2 $1 | awk '{for (i = 2; i <= NF; i++) print $i}'
+}
+
+# Every appended data value of a VTK file read as Float64 (the UInt64 size headers are read too)
+vtkNumbers() {
+	local start=$(grep -abo '<AppendedData encoding="raw">' $1 | head -1 | cut -d: -f1)
+	local end=$(grep -abo '</AppendedData>' $1 | tail -1 | cut -d: -f1)
+	local first=$(($(tail -c +$((start + 1)) $1 | grep -abo '_' | head -1 | cut -d: -f1) + start + 1))
+	tail -c +$((first + 1)) $1 | head -c $(((end - first) / 8 * 8)) | od -An -v -t f8 | tr -s ' ' '\n' | grep -v '^$'
+}
+
+# Largest difference of two columns relative to the largest value of the second (inf if they differ in length or in a non-finite value)
+maxRelDiff() {
+	awk '{
+			if (NF != 2) bad = 1
+			else if ($1 ~ /nan|inf/ || $2 ~ /nan|inf/) { if ($1 != $2) bad = 1 }
+			else {
+				diff = $1 - $2
+				if (diff < 0) diff = -diff
+				if (diff > maxAbs) maxAbs = diff
+				if ($2 > big) big = $2
+				if (-$2 > big) big = -$2
+			}
+		}
+		END {
+			if (bad) print "inf"
+			else printf "%.3e\n", (big > 0 ? maxAbs / big : maxAbs)
+		}'
+}
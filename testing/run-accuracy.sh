@@ -0,0 +1,129 @@
+#!/bin/bash
+
+# Setup some safe shell options
+set -eu -o pipefail
+
+# Cases to check (need RefData from store-ref-data)
+accCases="${ACC_CASES:-Cylinder TurekHron}"
+
+# Option overrides (e.g. POP_PRECISION=eFloat)
+if [ $# -eq 0 ]
+then
+	set -- POP_PRECISION=eFloatDelta
+fi
+
+# Check there is reference data for every case and that it was all made with the same build options
+firstCase=${accCases%% *}
+for case in $accCases
+do
+	if [ ! -d $case/RefData ]; then
+		printf "\nThere is no reference data for $case case...exiting\n\n"
+		exit 1
+	fi
+	if ! cmp -s $case/RefData/params.h $firstCase/RefData/params.h; then
+		printf "\nBuild options in $case and $firstCase RefData do not match...exiting\n\n"
+		exit 1
+	fi
+done
+
+# Build in a scratch copy of the source so inc/params.h is never edited (removed on exit)
+buildDir=$(mktemp -d)
+trap 'rm -rf "$buildDir"' EXIT
+cp -r ../src ../inc ../makefile $buildDir/.
+mkdir $buildDir/obj
+
+# Start from the RefData build options
+cp $firstCase/RefData/params.h $buildDir/inc/params.h
+
+# Apply the option overrides
+for opt in "$@"
+do
+	key=${opt%%=*}
+	val=${opt#*=}
+	if grep -q "#define $key\b" $buildDir/inc/params.h; then
+		sed -i "/#define $key\b/c\#define $key $val" $buildDir/inc/params.h
+	else
+		printf "\nOption $key is not in params.h...exiting\n\n"
+		exit 1
+	fi
+done
+
+# Build LIFE once
+(cd $buildDir && make -j 8)
+
+# Run all the cases
+for case in $accCases
+do
+
+	# Print header
+	printf "\nRunning $case accuracy check ($*)!\n\n"
+
+	# Clean/create the accuracy directory
+	accDir=$case/Accuracy
+	rm -rf $accDir
+	mkdir -p $accDir
+
+	# Copy case to accuracy directory
+	cp $buildDir/LIFE $accDir/.
+
+	# Copy the case and geometry config files
+	cp -r $case/RefData/input $accDir/.
+
+	# Run the case
+	(cd $accDir && ./LIFE > $case.out)
+
+	# If TurekHron case then run again to test restart feature
+	if [ $case == "TurekHron" ]; then
+		(cd $accDir && ./LIFE >> $case.out)
+	fi
+
+	# Print finish
+	printf "Finished running $case accuracy check!\n\n"
+done
+
+# Print header
+printf "\n\n\nComparing against reference data ($*)...\n\n"
+
+# Compare the time history outputs column by column
+for case in $accCases
+do
+	for refFile in $case/RefData/Results/*.out
+	do
+
+		# Get file name (skip the log)
+		file=${refFile##*/}
+		if [ $file == "Log.out" ]; then
+			continue
+		fi
+
+		# Check if results exist
+		if [ ! -f $case/Accuracy/Results/$file ]; then
+			printf "MISSING -> $case/$file\n"
+			continue
+		fi
+
+		# Max absolute difference and max difference relative to the largest reference value of that column
+		awk 'NR == FNR {
+				if (FNR > 1) {
+					for (i = 1; i <= NF; i++) {
+						ref[FNR, i] = $i
+						if ($i > big[i]) big[i] = $i
+						if (-$i > big[i]) big[i] = -$i
+					}
+				}
+				next
+			}
+			FNR > 1 {
+				for (i = 1; i <= NF; i++) {
+					diff = $i - ref[FNR, i]
+					if (diff < 0) diff = -diff
+					if (diff > maxAbs) maxAbs = diff
+					if (big[i] > 0 && diff / big[i] > maxRel) maxRel = diff / big[i]
+				}
+			}
+			END {
+				printf "%s -> max abs diff = %.3e, max rel diff = %.3e\n", name, maxAbs, maxRel
+			}' name="$case/$file" $refFile $case/Accuracy/Results/$file
+	done
+done
+printf "\n"
@@ -0,0 +1,75 @@
+#!/bin/bash
+
+# Setup some safe shell options
+set -eu -o pipefail
+
+# No arguments
+if [ $# -lt 1 ]
+then
+	printf "\nPlease enter a case name from the examples (and optional OPTION=value or PARAMETER=value overrides)...exiting\n\n"
+	exit 1
+fi
+
+# Get case path and name
+casePath=../examples/${1%/}
+caseName=${casePath##*/}
+shift
+
+# Check if it is a real case
+if [ ! -d $casePath ]; then
+	printf "\nCase name is not a real example case...exiting\n\n"
+	exit 1
+fi
+
+# Set the number of time steps to run for
+benchSteps=${BENCH_STEPS:-1000}
+
+# Print header
+printf "\nRunning $caseName benchmark!\n\n"
+
+# Clean/create the benchmark directory
+benchDir=Benchmark/$caseName
+rm -rf $benchDir
+mkdir -p $benchDir
+
+# Copy the case and geometry config files to the benchmark directory
+cp -r $casePath/input $benchDir/.
+caseConfig=$benchDir/input/case.config
+
+# Modify the write out frequencies for benchmarking
+sed -i "s/^nSteps\b.*/nSteps = $benchSteps/" $caseConfig
+sed -i "s/^tinfo\b.*/tinfo = nSteps \/ 10/" $caseConfig
+sed -i "s/^tVTK\b.*/tVTK = nSteps/" $caseConfig
+sed -i "s/^tRestart\b.*/tRestart = 0/" $caseConfig
+
+# Build in a scratch copy of the source so inc/params.h is never edited (removed on exit)
+buildDir=$(mktemp -d)
+trap 'rm -rf "$buildDir"' EXIT
+cp -r ../src ../inc ../makefile $buildDir/.
+mkdir $buildDir/obj
+
+# Apply the overrides (build options in params.h, e.g. LAYOUT=eSoA, or case parameters, e.g. resFactor=4)
+for opt in "$@"
+do
+	key=${opt%%=*}
+	val=${opt#*=}
+	if grep -q "#define $key\b" $buildDir/inc/params.h; then
+		sed -i "/#define $key\b/c\#define $key $val" $buildDir/inc/params.h
+	elif grep -q "^$key\b" $caseConfig; then
+		sed -i "s/^$key\b.*/$key = $val/" $caseConfig
+	else
+		echo "$key = $val" >> $caseConfig
+	fi
+done
+
+# Build LIFE
+(cd $buildDir && make -j 8)
+
+# Copy case to benchmark directory
+cp $buildDir/LIFE $benchDir/.
+
+# Run the case
+(cd $benchDir && ./LIFE > $caseName.out)
+
+# Report the MLUPS at the end of the run
+printf "\n$caseName ($*): $(grep "MLUPS" $benchDir/$caseName.out | tail -1)\n\n"
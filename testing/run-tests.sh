@@ -7,8 +7,8 @@ set -eu -o pipefail
 if [ $# -eq 0 ]
 then
 
-	# Set testCases
-	testCases=`ls -d */`
+	# Set testCases (every example)
+	testCases=`cd ../examples && ls -d */`
 
 # One argument
 elif [ $# -eq 1 ]
@@ -17,7 +17,7 @@ then
 	# Check if it is a real case
 	if [ ! -d $1 ]; then
 		printf "\nCase name is not a real example case...exiting\n\n"
-		exit
+		exit 1
 	fi
 
 	# Set testCases
@@ -27,9 +27,39 @@ then
 elif [ $# -gt 1 ]
 then
 	printf "\nToo many arguments...exiting\n\n"
-	exit
+	exit 1
 fi
 
+# Build helper
+source build-life.sh
+
+# Check there is reference data for every case and that it was stored with case.config (older reference data has the case in params.h)
+for d in $testCases
+do
+	case=${d%/}
+	if [ ! -d $case/RefData ]; then
+		printf "\nThere is no reference data for $case case...exiting\n\n"
+		exit 1
+	fi
+	if [ ! -f $case/RefData/input/case.config ]; then
+		printf "\nReference data for $case case has no input/case.config (regenerate it with store-ref-data.sh)...exiting\n\n"
+		exit 1
+	fi
+done
+
+# Build LIFE in a scratch directory for each set of build options in the reference data (removed on exit)
+buildRoot=$(mktemp -d)
+trap 'rm -rf "$buildRoot"' EXIT
+for d in $testCases
+do
+	case=${d%/}
+	buildDir=$buildRoot/$(md5sum < $case/RefData/params.h | cut -c 1-32)
+	if [ ! -d $buildDir ]; then
+		printf "\nBuilding LIFE with the build options of $case/RefData/params.h\n\n"
+		buildLife $case/RefData/params.h $buildDir
+	fi
+done
+
 # Run all the cases
 for d in $testCases
 do
@@ -40,28 +70,14 @@ do
 	# Print header
 	printf "\nRunning $case test!\n\n"
 
-	# Check if there is reference data
-	if [ ! -d $case/RefData ]; then
-		printf "\nThere is no reference data for $case case...exiting\n\n"
-		exit
-	fi
-
 	# Clean the directory first
 	rm -rf $case/LIFE $case/Results $case/$case.diff
 
-	# Copy params.h from RefData into src folder
-	cp $case/RefData/params.h ../inc/params.h
+	# Copy case to directory (built with the reference data build options)
+	cp $buildRoot/$(md5sum < $case/RefData/params.h | cut -c 1-32)/LIFE $case/.
 
-	# Build LIFE
-	(cd .. && make clean && make -j 8)
-
-	# Copy case to directory
-	cp ../LIFE $case/.
-
-	# Check if there a geometry.config file
-	if [ -d $case/RefData/input ]; then
-		cp -r $case/RefData/input $case/.
-	fi
+	# Copy the case and geometry config files
+	cp -r $case/RefData/input $case/.
 
 	# Run the case
 	(cd $case && ./LIFE)
@@ -109,9 +125,20 @@ do
 	fi
 done
 
+# Check the example case configs still give the reference parameters
+if ! ./check-case-configs.sh; then
+	nFails=$((nFails+1))
+fi
+
+# Check the build option sets and thread counts against the default build (when testing every case)
+if [ $# -eq 0 ] && ! ./check-build-options.sh; then
+	nFails=$((nFails+1))
+fi
+
 # Check if fails is more than zero times
 if [ $nFails -eq 0 ]; then
 	printf "\n${green}PASSED ALL TESTS!${normal}\n\n"
 else
 	printf "\n${red}FAILED SOME TESTS!${normal}\n\n"
+	exit 1
 fi
@@ -3,6 +3,11 @@
 # Setup some safe shell options
 set -eu -o pipefail
 
+# Build LIFE in a scratch directory for each set of example build options on top of inc/params.h (removed on exit, every case is read in from its input/case.config)
+source build-life.sh
+buildRoot=$(mktemp -d)
+trap 'rm -rf "$buildRoot"' EXIT
+
 # Find all example cases
 for d in ../examples/*/
 do
@@ -16,33 +21,34 @@ do
 	# Print header
 	printf "\nStoring new $caseName RefData!\n\n"
 
+	# Build with the example build options (if it has any)
+	buildOptions=""
+	if [ -f $casePath/build.options ]; then
+		buildOptions=$(grep -v "^#" $casePath/build.options | xargs)
+	fi
+	buildDir=$buildRoot/$(echo "$buildOptions" | md5sum | cut -c 1-32)
+	if [ ! -d $buildDir ]; then
+		buildLife ../inc/params.h $buildDir $buildOptions
+	fi
+
 	# Clean/create the case directory
 	rm -rf $caseName
 	mkdir $caseName
 
-	# Copy params.h from examples into src folder
-	cp $casePath/params.h ../inc/params.h
-
-	# Modifiy the write out frequencies for testing
-	sed -i "/const int nSteps/c\const int nSteps = 500;" ../inc/params.h
-	sed -i "/const int tinfo/c\const int tinfo = nSteps / 50;" ../inc/params.h
-	sed -i "/const int tVTK/c\const int tVTK = nSteps / 10;" ../inc/params.h
-	sed -i "/const int tRestart/c\const int tRestart = nSteps / 5;" ../inc/params.h
-
-	# Build LIFE
-	(cd .. && make clean && make -j 8)
-
 	# Create ref directory
 	mkdir $caseName/RefData
 
-	# Copy case to RefData
-	cp ../LIFE $caseName/RefData/.
-	cp ../inc/params.h $caseName/RefData/.
+	# Copy case to RefData (params.h holds the build options)
+	cp $buildDir/LIFE $caseName/RefData/.
+	cp $buildDir/inc/params.h $caseName/RefData/.
+	cp -r $casePath/input $caseName/RefData/.
 
-	# Check if there a geometry.config file
-	if [ -d $casePath/input ]; then
-		cp -r $casePath/input $caseName/RefData/.
-	fi
+	# Modifiy the write out frequencies for testing
+	caseConfig=$caseName/RefData/input/case.config
+	sed -i "s/^nSteps\b.*/nSteps = 500/" $caseConfig
+	sed -i "s/^tinfo\b.*/tinfo = nSteps \/ 50/" $caseConfig
+	sed -i "s/^tVTK\b.*/tVTK = nSteps \/ 10/" $caseConfig
+	sed -i "s/^tRestart\b.*/tRestart = nSteps \/ 5/" $caseConfig
 
 	# Run the case
 	(cd $caseName/RefData && ./LIFE)